@@ -0,0 +1,129 @@
+#include "triangle.hpp"
+#include "octree.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+using namespace geometry;
+
+/* every allocation of the process is counted, bench_allocations() reads the counter around the narrow phase.
+   All forms are replaced so that no pair of new and delete mixes this allocator with the default one.
+   The replacements are not inlined, otherwise gcc matches malloc() and free() inside them against new and delete and warns */
+static std::atomic<size_t> allocation_num{0};
+
+static void* counted_alloc(std::size_t size, std::align_val_t align = std::align_val_t{alignof(std::max_align_t)})
+{
+    allocation_num.fetch_add(1, std::memory_order_relaxed);
+
+    size_t alignment = static_cast<size_t>(align);
+    if (size == 0) size = 1;
+
+    if (alignment <= alignof(std::max_align_t)) return std::malloc(size);
+
+    return std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+}
+
+static void* counted_new(std::size_t size, std::align_val_t align = std::align_val_t{alignof(std::max_align_t)})
+{
+    if (void *ptr = counted_alloc(size, align)) return ptr;
+    throw std::bad_alloc{};
+}
+
+__attribute__((noinline)) void* operator new  (std::size_t size) { return counted_new(size); }
+__attribute__((noinline)) void* operator new[](std::size_t size) { return counted_new(size); }
+
+__attribute__((noinline)) void* operator new  (std::size_t size, std::align_val_t align) { return counted_new(size, align); }
+__attribute__((noinline)) void* operator new[](std::size_t size, std::align_val_t align) { return counted_new(size, align); }
+
+__attribute__((noinline)) void* operator new  (std::size_t size, const std::nothrow_t&) noexcept { return counted_alloc(size); }
+__attribute__((noinline)) void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return counted_alloc(size); }
+
+__attribute__((noinline)) void* operator new  (std::size_t size, std::align_val_t align, const std::nothrow_t&) noexcept { return counted_alloc(size, align); }
+__attribute__((noinline)) void* operator new[](std::size_t size, std::align_val_t align, const std::nothrow_t&) noexcept { return counted_alloc(size, align); }
+
+__attribute__((noinline)) void operator delete  (void *ptr) noexcept { std::free(ptr); }
+__attribute__((noinline)) void operator delete[](void *ptr) noexcept { std::free(ptr); }
+
+__attribute__((noinline)) void operator delete  (void *ptr, std::size_t) noexcept { std::free(ptr); }
+__attribute__((noinline)) void operator delete[](void *ptr, std::size_t) noexcept { std::free(ptr); }
+
+__attribute__((noinline)) void operator delete  (void *ptr, std::align_val_t) noexcept { std::free(ptr); }
+__attribute__((noinline)) void operator delete[](void *ptr, std::align_val_t) noexcept { std::free(ptr); }
+
+__attribute__((noinline)) void operator delete  (void *ptr, std::size_t, std::align_val_t) noexcept { std::free(ptr); }
+__attribute__((noinline)) void operator delete[](void *ptr, std::size_t, std::align_val_t) noexcept { std::free(ptr); }
+
+__attribute__((noinline)) void operator delete  (void *ptr, const std::nothrow_t&) noexcept { std::free(ptr); }
+__attribute__((noinline)) void operator delete[](void *ptr, const std::nothrow_t&) noexcept { std::free(ptr); }
+
+__attribute__((noinline)) void operator delete  (void *ptr, std::align_val_t, const std::nothrow_t&) noexcept { std::free(ptr); }
+__attribute__((noinline)) void operator delete[](void *ptr, std::align_val_t, const std::nothrow_t&) noexcept { std::free(ptr); }
+
+const size_t ALLOC_BENCH_WINDOW = 64; // by default every triag is tested against this many next ones
+
+/**
+ * \brief calls triangle_t::intersects() for every triag and the window triags after it in the input,
+ *        prints the number of calls, of heap allocations made by them and the time
+*/
+static void bench_allocations(const std::vector<octrees::triag_id_t> &triags, size_t window)
+{
+    size_t call_num = 0, hit_num = 0;
+
+    auto   start       = std::chrono::steady_clock::now();
+    size_t first_alloc = allocation_num.load(std::memory_order_relaxed);
+
+    for (size_t i = 0, num = triags.size(); i < num; ++i)
+        for (size_t j = i + 1, end = std::min(num, i + 1 + window); j < end; ++j, ++call_num)
+            hit_num += triags[i].triag.intersects(triags[j].triag);
+
+    size_t alloc_num = allocation_num.load(std::memory_order_relaxed) - first_alloc;
+    double time      = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "narrow phase: " << call_num << " calls, " << hit_num << " hits, " << alloc_num << " allocations ("
+              << (call_num ? static_cast<double>(alloc_num) / call_num : 0) << " per call), " << time << " s ("
+              << (call_num ? time * 1e9 / call_num : 0) << " ns per call)" << std::endl;
+}
+
+/**
+ * usage: bench_alloc [WINDOW] < scene
+ * the scene is read in the format of the triangles program
+*/
+int main(int argc, char **argv)
+{
+    size_t window = ALLOC_BENCH_WINDOW;
+
+    if (argc > 2 || (argc == 2 && (window = std::strtoul(argv[1], nullptr, 10)) == 0))
+    {
+        std::cerr << "usage: " << argv[0] << " [WINDOW] < scene" << std::endl;
+        return -1;
+    }
+
+    size_t triag_num = 0;
+    std::cin >> triag_num;
+
+    std::vector<octrees::triag_id_t> triags;
+    triags.reserve(triag_num);
+
+    for (size_t i = 0; i < triag_num; i++)
+    {
+        double crds[9] = {};
+        for (double &crd : crds) std::cin >> crd;
+
+        triags.push_back({triangle_t{point_t{crds[0], crds[1], crds[2]}, point_t{crds[3], crds[4], crds[5]},
+                                     point_t{crds[6], crds[7], crds[8]}}, i});
+    }
+
+    if (!std::cin)
+    {
+        std::cerr << "expected " << triag_num << " triangles" << std::endl;
+        return -1;
+    }
+
+    bench_allocations(triags, window);
+
+    return 0;
+}
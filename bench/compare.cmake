@@ -0,0 +1,21 @@
+# runs the narrow phase benchmark built with and without ASSERT checks on the same scene REPEAT times each
+# and prints the best time per call: cmake -DCHECKED=... -DRELEASE=... -DSCENE=... -DWINDOW=... -DREPEAT=... -P compare.cmake
+foreach (bench ${CHECKED} ${RELEASE})
+    get_filename_component(name ${bench} NAME)
+    set(best "")
+
+    foreach (run RANGE 1 ${REPEAT})
+        execute_process(COMMAND ${bench} ${WINDOW} INPUT_FILE ${SCENE} OUTPUT_VARIABLE result RESULT_VARIABLE status)
+
+        if (NOT status EQUAL 0 OR NOT result MATCHES "\\(([0-9.e+-]+) ns per call\\)")
+            message(FATAL_ERROR "${bench} failed on ${SCENE}")
+        endif()
+
+        if (best STREQUAL "" OR CMAKE_MATCH_1 LESS best)
+            set(best ${CMAKE_MATCH_1})
+        endif()
+    endforeach()
+
+    string(REGEX REPLACE ", [^,]* s \\(.*" "" calls "${result}")
+    message("${name}: ${calls}, best of ${REPEAT}: ${best} ns per call")
+endforeach()
@@ -0,0 +1,19 @@
+# NATIVE_ARCH=ON compiles for the host CPU so the batched narrow phase uses AVX2 or AVX-512.
+# It is off by default: such binaries don't run on older CPUs. Included by the main, tests and bench projects,
+# the flag is added once for the directory that includes it first and its subdirectories
+if (DEFINED NATIVE_ARCH_INCLUDED)
+    return()
+endif()
+
+set(NATIVE_ARCH_INCLUDED ON)
+
+option(NATIVE_ARCH "Compile for the host CPU so the batched narrow phase uses AVX2 or AVX-512" OFF)
+
+if (NATIVE_ARCH)
+    include(CheckCXXCompilerFlag)
+    check_cxx_compiler_flag(-march=native HAS_MARCH_NATIVE)
+
+    if (HAS_MARCH_NATIVE)
+        add_compile_options(-march=native)
+    endif()
+endif()
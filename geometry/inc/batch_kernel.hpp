@@ -0,0 +1,664 @@
+#pragma once
+#include "double_operations.hpp"
+#include "triangle.hpp"
+#include <algorithm>
+#include <array>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <new>
+#include <vector>
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+using namespace doperations;
+using namespace geometry;
+
+
+namespace kernels {
+
+const size_t BATCH_SIZE = 64; // candidates in one mask of filter_mask()
+
+/**
+ * \brief slack of the filter for blocks of real_t. The filter never rejects a pair the scalar kernel accepts:
+ *        every threshold is moved by the rounding of the block values and of the arithmetic on them
+*/
+template <typename real_t>
+struct precision_t;
+
+template <>
+struct precision_t<double>
+{
+    static constexpr double sphere_rel = 1e-12;           // relative slack of the sphere test against the rounding of the scalar kernel
+    static constexpr double normal_abs = 1e-12;           // absolute slack of the tests on unit normals
+    static constexpr double plane_eps  = 64 * DBL_EPSILON; // slack of the plane distances per unit of coordinate magnitude
+    static constexpr double store_eps  = 0;                // the block keeps the values of triangle_t as they are
+    static constexpr double max_scale  = DBL_MAX;
+};
+
+/**
+ * \brief coordinates are rounded to float when stored and the sums of squares overflow float above max_scale,
+ *        so float blocks are built only for scenes with smaller coordinates
+*/
+template <>
+struct precision_t<float>
+{
+    static constexpr double sphere_rel = 1.0 / 16;
+    static constexpr double normal_abs = 1e-6;
+    static constexpr double plane_eps  = 64 * FLT_EPSILON;
+    static constexpr double store_eps  = FLT_EPSILON;
+    static constexpr double max_scale  = 1e12;
+};
+
+/**
+ * \brief lanes of one register, the kernel is written once over this interface.
+ *        Comparisons are ordered, so NaN lanes always compare false.
+*/
+template <typename real_t>
+struct scalar_lanes_t
+{
+    using reg_t = real_t;
+    static const size_t width = 1;
+
+    static reg_t load(const real_t *ptr) { return *ptr; }
+    static reg_t set(real_t val) { return val; }
+
+    static reg_t add(reg_t a, reg_t b) { return a + b; }
+    static reg_t sub(reg_t a, reg_t b) { return a - b; }
+    static reg_t mul(reg_t a, reg_t b) { return a * b; }
+    static reg_t abs(reg_t a) { return std::abs(a); }
+    static reg_t min(reg_t a, reg_t b) { return std::min(a, b); }
+    static reg_t max(reg_t a, reg_t b) { return std::max(a, b); }
+
+    static unsigned gt(reg_t a, reg_t b) { return a > b; }
+    static unsigned ge(reg_t a, reg_t b) { return a >= b; }
+};
+
+#if defined(__AVX2__)
+struct avx2_lanes_t
+{
+    using reg_t = __m256d;
+    static const size_t width = 4;
+
+    static reg_t load(const double *ptr) { return _mm256_loadu_pd(ptr); }
+    static reg_t set(double val) { return _mm256_set1_pd(val); }
+
+    static reg_t add(reg_t a, reg_t b) { return _mm256_add_pd(a, b); }
+    static reg_t sub(reg_t a, reg_t b) { return _mm256_sub_pd(a, b); }
+    static reg_t mul(reg_t a, reg_t b) { return _mm256_mul_pd(a, b); }
+    static reg_t abs(reg_t a) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a); }
+    static reg_t min(reg_t a, reg_t b) { return _mm256_min_pd(a, b); }
+    static reg_t max(reg_t a, reg_t b) { return _mm256_max_pd(a, b); }
+
+    static unsigned gt(reg_t a, reg_t b) { return static_cast<unsigned>(_mm256_movemask_pd(_mm256_cmp_pd(a, b, _CMP_GT_OQ))); }
+    static unsigned ge(reg_t a, reg_t b) { return static_cast<unsigned>(_mm256_movemask_pd(_mm256_cmp_pd(a, b, _CMP_GE_OQ))); }
+};
+
+struct avx2_float_lanes_t
+{
+    using reg_t = __m256;
+    static const size_t width = 8;
+
+    static reg_t load(const float *ptr) { return _mm256_loadu_ps(ptr); }
+    static reg_t set(float val) { return _mm256_set1_ps(val); }
+
+    static reg_t add(reg_t a, reg_t b) { return _mm256_add_ps(a, b); }
+    static reg_t sub(reg_t a, reg_t b) { return _mm256_sub_ps(a, b); }
+    static reg_t mul(reg_t a, reg_t b) { return _mm256_mul_ps(a, b); }
+    static reg_t abs(reg_t a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+    static reg_t min(reg_t a, reg_t b) { return _mm256_min_ps(a, b); }
+    static reg_t max(reg_t a, reg_t b) { return _mm256_max_ps(a, b); }
+
+    static unsigned gt(reg_t a, reg_t b) { return static_cast<unsigned>(_mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_GT_OQ))); }
+    static unsigned ge(reg_t a, reg_t b) { return static_cast<unsigned>(_mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_GE_OQ))); }
+};
+#endif
+
+#if defined(__AVX512F__)
+struct avx512_lanes_t
+{
+    using reg_t = __m512d;
+    static const size_t width = 8;
+
+    static reg_t load(const double *ptr) { return _mm512_loadu_pd(ptr); }
+    static reg_t set(double val) { return _mm512_set1_pd(val); }
+
+    static reg_t add(reg_t a, reg_t b) { return _mm512_add_pd(a, b); }
+    static reg_t sub(reg_t a, reg_t b) { return _mm512_sub_pd(a, b); }
+    static reg_t mul(reg_t a, reg_t b) { return _mm512_mul_pd(a, b); }
+    static reg_t abs(reg_t a) { return _mm512_abs_pd(a); }
+    /* blends and not _mm512_min_pd(), whose undefined source register GCC 12 takes for an uninitialized variable */
+    static reg_t min(reg_t a, reg_t b) { return _mm512_mask_blend_pd(_mm512_cmp_pd_mask(b, a, _CMP_LT_OQ), a, b); }
+    static reg_t max(reg_t a, reg_t b) { return _mm512_mask_blend_pd(_mm512_cmp_pd_mask(b, a, _CMP_GT_OQ), a, b); }
+
+    static unsigned gt(reg_t a, reg_t b) { return static_cast<unsigned>(_mm512_cmp_pd_mask(a, b, _CMP_GT_OQ)); }
+    static unsigned ge(reg_t a, reg_t b) { return static_cast<unsigned>(_mm512_cmp_pd_mask(a, b, _CMP_GE_OQ)); }
+};
+
+struct avx512_float_lanes_t
+{
+    using reg_t = __m512;
+    static const size_t width = 16;
+
+    static reg_t load(const float *ptr) { return _mm512_loadu_ps(ptr); }
+    static reg_t set(float val) { return _mm512_set1_ps(val); }
+
+    static reg_t add(reg_t a, reg_t b) { return _mm512_add_ps(a, b); }
+    static reg_t sub(reg_t a, reg_t b) { return _mm512_sub_ps(a, b); }
+    static reg_t mul(reg_t a, reg_t b) { return _mm512_mul_ps(a, b); }
+    static reg_t abs(reg_t a) { return _mm512_abs_ps(a); }
+    static reg_t min(reg_t a, reg_t b) { return _mm512_mask_blend_ps(_mm512_cmp_ps_mask(b, a, _CMP_LT_OQ), a, b); }
+    static reg_t max(reg_t a, reg_t b) { return _mm512_mask_blend_ps(_mm512_cmp_ps_mask(b, a, _CMP_GT_OQ), a, b); }
+
+    static unsigned gt(reg_t a, reg_t b) { return static_cast<unsigned>(_mm512_cmp_ps_mask(a, b, _CMP_GT_OQ)); }
+    static unsigned ge(reg_t a, reg_t b) { return static_cast<unsigned>(_mm512_cmp_ps_mask(a, b, _CMP_GE_OQ)); }
+};
+#endif
+
+/**
+ * \brief the widest lanes of real_t the build supports
+*/
+template <typename real_t>
+struct widest_lanes { using type = scalar_lanes_t<real_t>; };
+
+#if defined(__AVX512F__)
+template <> struct widest_lanes<double> { using type = avx512_lanes_t; };
+template <> struct widest_lanes<float>  { using type = avx512_float_lanes_t; };
+#elif defined(__AVX2__)
+template <> struct widest_lanes<double> { using type = avx2_lanes_t; };
+template <> struct widest_lanes<float>  { using type = avx2_float_lanes_t; };
+#endif
+
+template <typename real_t>
+using lanes_t = typename widest_lanes<real_t>::type;
+
+/*==========================================================================*/
+
+/**
+ * \brief the bounding boxes are not stored, a lane takes them as the minima and maxima of the vertices.
+ *        The centers are, the sphere test reads them for every candidate and most candidates stop there
+*/
+enum block_field
+{
+    CENTER_X, CENTER_Y, CENTER_Z, // triangle_t::get_center_x3()
+    RAD_SQ,                       // triangle_t::get_bounding_rad_sq()
+    PLANE_A, PLANE_B, PLANE_C, PLANE_D,
+    AX, AY, AZ, BX, BY, BZ, CX, CY, CZ,
+    IS_TRIAG,                     // 1 for TRIAG, 0 for degenerate triags
+    FIELD_NUM
+};
+
+inline std::array<double, FIELD_NUM> get_fields(const triangle_t &triag)
+{
+    vector_t center = triag.get_center_x3();
+    plane_t  plane  = triag.get_plane();
+    point_t  A = triag.getA(), B = triag.getB(), C = triag.getC();
+
+    return {center.get_x(), center.get_y(), center.get_z(), triag.get_bounding_rad_sq(),
+            plane.get_a(), plane.get_b(), plane.get_c(), plane.get_d(),
+            A.get_x(), A.get_y(), A.get_z(), B.get_x(), B.get_y(), B.get_z(), C.get_x(), C.get_y(), C.get_z(),
+            (triag.get_type() == TRIAG) ? 1.0 : 0.0};
+}
+
+/**
+ * \brief val rounded to real_t towards -inf if dir < 0, towards +inf if dir > 0, to nearest otherwise
+*/
+template <typename real_t>
+real_t round_to(double val, int dir)
+{
+    real_t res = static_cast<real_t>(val);
+
+    if (dir < 0 && res > val) return std::nextafter(res, -std::numeric_limits<real_t>::infinity());
+    if (dir > 0 && res < val) return std::nextafter(res,  std::numeric_limits<real_t>::infinity());
+
+    return res;
+}
+
+/**
+ * \brief largest magnitude the plane distances of the triag are computed from
+*/
+inline double get_scale(const std::array<double, FIELD_NUM> &fields)
+{
+    double scale = std::abs(fields[PLANE_D]);
+    for (int f = AX; f <= CZ; ++f) scale = std::max(scale, std::abs(fields[f]));
+
+    return scale;
+}
+
+/**
+ * \brief largest coordinate magnitude of the triag
+*/
+inline double get_crd_scale(const std::array<double, FIELD_NUM> &fields)
+{
+    double scale = 0;
+    for (int f = AX; f <= CZ; ++f) scale = std::max(scale, std::abs(fields[f]));
+
+    return scale;
+}
+
+/**
+ * \brief allocator of cache line aligned arrays, so a lane load never splits more lines than it has to
+*/
+template <typename T>
+struct aligned_allocator_t
+{
+    using value_type = T;
+
+    static const size_t alignment = 64;
+
+    aligned_allocator_t() = default;
+
+    template <typename U>
+    aligned_allocator_t(const aligned_allocator_t<U>&) {}
+
+    T* allocate(size_t num) { return static_cast<T*>(::operator new(num * sizeof(T), std::align_val_t{alignment})); }
+
+    void deallocate(T *ptr, size_t) { ::operator delete(ptr, std::align_val_t{alignment}); }
+
+    template <typename U>
+    bool operator==(const aligned_allocator_t<U>&) const { return true; }
+
+    template <typename U>
+    bool operator!=(const aligned_allocator_t<U>&) const { return false; }
+};
+
+/**
+ * \brief compact precomputed form of a triag sequence for the hot loops: one 64-byte aligned array per block_field.
+ *        A test of a lane reads sizeof(real_t) bytes of every field it needs where a pair of triangle_t takes about 300 bytes,
+ *        the exact test is left for the few candidates the filter keeps. A float block takes half the memory
+ *        and twice the lanes of a register, precision_t<float> keeps its filter conservative
+*/
+template <typename real_t>
+class basic_triag_block_t
+{
+    using field_vector = std::vector<real_t, aligned_allocator_t<real_t>>;
+
+    /* storage of a pushed block, empty when the block views arrays kept by someone else (an index file) */
+    std::array<field_vector, FIELD_NUM> fields_;
+
+    /* the kernels read the fields only through these, they point to fields_ or to the viewed arrays */
+    std::array<const real_t*, FIELD_NUM> data_{};
+    size_t size_      = 0;
+    double scale_     = 0;
+    double crd_scale_ = 0;
+
+    void sync()
+    {
+        for (int f = 0; f < FIELD_NUM; ++f) data_[f] = fields_[f].data();
+        size_ = fields_[0].size();
+    }
+
+    public:
+
+    using value_type = real_t;
+
+    basic_triag_block_t() = default;
+
+    /**
+     * \brief views num values of every field, scale and crd_scale are those of the block the arrays were taken from
+    */
+    basic_triag_block_t(const std::array<const real_t*, FIELD_NUM> &data, size_t num, double scale, double crd_scale) :
+        data_(data), size_(num), scale_(scale), crd_scale_(crd_scale) {}
+
+    /* data_ point into fields_, moving a vector keeps its buffer but copying does not */
+    basic_triag_block_t(const basic_triag_block_t&) = delete;
+    basic_triag_block_t& operator=(const basic_triag_block_t&) = delete;
+
+    basic_triag_block_t(basic_triag_block_t&&) = default;
+    basic_triag_block_t& operator=(basic_triag_block_t&&) = default;
+
+    void reserve(size_t num)
+    {
+        for (auto &field : fields_) field.reserve(num);
+        sync();
+    }
+
+    void push_back(const triangle_t &triag)
+    {
+        std::array<double, FIELD_NUM> fields = get_fields(triag);
+
+        for (int f = 0; f < FIELD_NUM; ++f) fields_[f].push_back(static_cast<real_t>(fields[f]));
+        sync();
+
+        if (fields[IS_TRIAG] > 0) scale_ = std::max(scale_, get_scale(fields));
+        crd_scale_ = std::max(crd_scale_, get_crd_scale(fields));
+    }
+
+    void clear()
+    {
+        for (auto &field : fields_) field = field_vector{};
+        sync();
+        scale_ = crd_scale_ = 0;
+    }
+
+    size_t size() const { return size_; }
+
+    double scale() const { return scale_; }
+
+    double crd_scale() const { return crd_scale_; }
+
+    /**
+     * \brief the filter over the block is conservative for these coordinates
+    */
+    bool fits() const { return std::max(scale_, crd_scale_) <= precision_t<real_t>::max_scale; }
+
+    double get(int field, size_t i) const { return data_[field][i]; }
+
+    /**
+     * \brief bounds of triag i along axis. The stored vertices of a float block are rounded to nearest,
+     *        so the bounds are moved outwards by twice that rounding and hold the exact ones
+    */
+    double get_min(int axis, size_t i) const
+    {
+        double crd = std::min({get(AX + axis, i), get(BX + axis, i), get(CX + axis, i)});
+        return crd - 2 * precision_t<real_t>::store_eps * std::abs(crd);
+    }
+
+    double get_max(int axis, size_t i) const
+    {
+        double crd = std::max({get(AX + axis, i), get(BX + axis, i), get(CX + axis, i)});
+        return crd + 2 * precision_t<real_t>::store_eps * std::abs(crd);
+    }
+
+    const real_t* data(int field) const { return data_[field]; }
+};
+
+using triag_block_t = basic_triag_block_t<double>;
+using float_block_t = basic_triag_block_t<float>;
+
+/**
+ * \brief triag tested against a block, its fields are broadcast to every lane
+*/
+template <typename real_t>
+struct basic_query_t
+{
+    std::array<real_t, FIELD_NUM> fields;
+    std::array<real_t, 3> box_min; // rounded outwards, so they hold the exact box
+    std::array<real_t, 3> box_max;
+    bool is_triag;
+    double scale;
+
+    explicit basic_query_t(const triangle_t &triag) : is_triag(triag.get_type() == TRIAG)
+    {
+        std::array<double, FIELD_NUM> exact = get_fields(triag);
+
+        for (int f = 0; f < FIELD_NUM; ++f) fields[f] = static_cast<real_t>(exact[f]);
+        scale = is_triag ? get_scale(exact) : 0;
+
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            box_min[axis] = round_to<real_t>(triple_min(exact[AX + axis], exact[BX + axis], exact[CX + axis]), -1);
+            box_max[axis] = round_to<real_t>(triple_max(exact[AX + axis], exact[BX + axis], exact[CX + axis]),  1);
+        }
+    }
+
+    basic_query_t(const basic_triag_block_t<real_t> &block, size_t i)
+    {
+        std::array<double, FIELD_NUM> exact;
+
+        for (int f = 0; f < FIELD_NUM; ++f)
+        {
+            fields[f] = block.data(f)[i];
+            exact[f]  = fields[f];
+        }
+
+        is_triag = fields[IS_TRIAG] > 0;
+        scale    = is_triag ? get_scale(exact) : 0;
+
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            box_min[axis] = round_to<real_t>(block.get_min(axis, i), -1);
+            box_max[axis] = round_to<real_t>(block.get_max(axis, i),  1);
+        }
+    }
+};
+
+using query_t = basic_query_t<double>;
+
+/**
+ * \brief thresholds of one filter_mask() call, moved by the slack of precision_t<real_t>
+*/
+struct filter_thr_t
+{
+    double sphere_coeff; // the spheres are apart when the squared distance of the centers x3 is above
+    double sphere_abs;   // sphere_coeff * (sum of rad_sq) + sphere_abs
+    double parallel;     // the planes cross when a coordinate of the cross product of the normals is above
+    double plane;        // a vertex is off a plane when its distance is above
+
+    /**
+     * \brief a center x3 is off by up to 3 * store_eps * crd_scale when stored and a difference of two by twice that
+     *        plus its own rounding. With this error delta, |d + delta|^2 <= (1 + rel / 2) |d|^2 + (1 + 2 / rel) 3 delta^2
+    */
+    template <typename real_t>
+    static filter_thr_t make(const basic_query_t<real_t> &query, const basic_triag_block_t<real_t> &block)
+    {
+        using prec = precision_t<real_t>;
+
+        double delta = 8 * prec::store_eps * block.crd_scale();
+
+        filter_thr_t thr;
+        thr.sphere_coeff = brad_coeff * (1 + prec::sphere_rel);
+        thr.sphere_abs   = (prec::store_eps > 0) ? 2 * (1 + 2 / prec::sphere_rel) * 3 * delta * delta + 64 * std::numeric_limits<real_t>::min() : 0;
+        thr.parallel     = ACCURACY + prec::normal_abs;
+        thr.plane        = ACCURACY + prec::normal_abs + prec::plane_eps * std::max(query.scale, block.scale());
+
+        return thr;
+    }
+};
+
+/*==========================================================================*/
+
+namespace detail {
+
+template <typename L>
+unsigned all_beyond(typename L::reg_t d0, typename L::reg_t d1, typename L::reg_t d2, typename L::reg_t thr)
+{
+    typename L::reg_t neg_thr = L::sub(L::set(0), thr);
+
+    return (L::gt(d0, thr) & L::gt(d1, thr) & L::gt(d2, thr)) |
+           (L::gt(neg_thr, d0) & L::gt(neg_thr, d1) & L::gt(neg_thr, d2));
+}
+
+/**
+ * \brief bits of the lanes [j, j + L::width) that the scalar kernel does not reject for sure. A lane is rejected when
+ *        the bounding spheres are apart, or when both are TRIAG, their planes cross and the vertices of one triag
+ *        are all on one side of the plane of the other. These are the first tests of triangle_t::intersects(),
+ *        every threshold is moved by the slack so rounding never rejects a pair the scalar kernel would accept.
+*/
+template <typename L, typename real_t>
+unsigned may_intersect(const basic_query_t<real_t> &query, const basic_triag_block_t<real_t> &block, size_t j, const filter_thr_t &thr)
+{
+    using reg_t = typename L::reg_t;
+
+    const std::array<real_t, FIELD_NUM> &q = query.fields;
+    auto field = [&block, j] (int f) { return L::load(block.data(f) + j); };
+
+    unsigned full = (1u << L::width) - 1;
+
+    reg_t dx = L::sub(L::set(q[CENTER_X]), field(CENTER_X));
+    reg_t dy = L::sub(L::set(q[CENTER_Y]), field(CENTER_Y));
+    reg_t dz = L::sub(L::set(q[CENTER_Z]), field(CENTER_Z));
+
+    reg_t dist = L::add(L::add(L::mul(dx, dx), L::mul(dy, dy)), L::mul(dz, dz));
+    reg_t rad  = L::add(L::mul(L::add(L::set(q[RAD_SQ]), field(RAD_SQ)), L::set(round_to<real_t>(thr.sphere_coeff, 1))),
+                        L::set(round_to<real_t>(thr.sphere_abs, 1)));
+
+    unsigned reject = L::gt(dist, rad);
+
+    if (!query.is_triag || reject == full) return ~reject & full;
+
+    unsigned triag = L::gt(field(IS_TRIAG), L::set(0.5));
+
+    reg_t na = field(PLANE_A), nb = field(PLANE_B), nc = field(PLANE_C), nd = field(PLANE_D);
+
+    reg_t cross_x = L::sub(L::mul(L::set(q[PLANE_B]), nc), L::mul(L::set(q[PLANE_C]), nb));
+    reg_t cross_y = L::sub(L::mul(L::set(q[PLANE_C]), na), L::mul(L::set(q[PLANE_A]), nc));
+    reg_t cross_z = L::sub(L::mul(L::set(q[PLANE_A]), nb), L::mul(L::set(q[PLANE_B]), na));
+
+    reg_t par_thr = L::set(round_to<real_t>(thr.parallel, 1));
+    unsigned crossing = L::gt(L::abs(cross_x), par_thr) | L::gt(L::abs(cross_y), par_thr) | L::gt(L::abs(cross_z), par_thr);
+
+    reg_t plane_thr = L::set(round_to<real_t>(thr.plane, 1));
+
+    auto query_dist = [&] (int x) {
+        return L::add(L::add(L::add(L::mul(na, L::set(q[x])), L::mul(nb, L::set(q[x + 1]))), L::mul(nc, L::set(q[x + 2]))), nd);
+    };
+
+    auto block_dist = [&] (int x) {
+        return L::add(L::add(L::add(L::mul(L::set(q[PLANE_A]), field(x)), L::mul(L::set(q[PLANE_B]), field(x + 1))),
+                             L::mul(L::set(q[PLANE_C]), field(x + 2))), L::set(q[PLANE_D]));
+    };
+
+    unsigned separated = all_beyond<L>(query_dist(AX), query_dist(BX), query_dist(CX), plane_thr) |
+                         all_beyond<L>(block_dist(AX), block_dist(BX), block_dist(CX), plane_thr);
+
+    reject |= triag & crossing & separated;
+
+    return ~reject & full;
+}
+
+/**
+ * \brief bits of the lanes [j, j + L::width) whose bounding boxes meet the box of the query. The boxes of the lanes are
+ *        the minima and maxima of the stored vertices, moved outwards like basic_triag_block_t::get_min() in a float block
+*/
+template <typename L, typename real_t>
+unsigned boxes_meet(const basic_query_t<real_t> &query, const basic_triag_block_t<real_t> &block, size_t j)
+{
+    using reg_t = typename L::reg_t;
+
+    auto field = [&block, j] (int f) { return L::load(block.data(f) + j); };
+
+    const real_t margin = 2 * precision_t<real_t>::store_eps;
+
+    unsigned apart = 0;
+
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        reg_t a = field(AX + axis), b = field(BX + axis), c = field(CX + axis);
+
+        reg_t lo = L::min(L::min(a, b), c);
+        reg_t hi = L::max(L::max(a, b), c);
+
+        if (margin > 0)
+        {
+            lo = L::sub(lo, L::mul(L::abs(lo), L::set(margin)));
+            hi = L::add(hi, L::mul(L::abs(hi), L::set(margin)));
+        }
+
+        apart |= L::gt(L::set(query.box_min[axis]), hi) | L::gt(lo, L::set(query.box_max[axis]));
+    }
+
+    return ~apart & ((1u << L::width) - 1);
+}
+
+/**
+ * \brief child_slots() of the lanes [j, j + L::width)
+*/
+template <typename L>
+void box_slots(const std::array<const double*, 3> &lo, const std::array<const double*, 3> &hi, size_t j,
+               const std::array<double, 3> &center, uint8_t *slots)
+{
+    unsigned inside = (1u << L::width) - 1;
+    unsigned neg[3];
+
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        typename L::reg_t c = L::set(center[axis]);
+
+        unsigned pos = L::ge(L::sub(L::load(lo[axis] + j), c), L::set(ACCURACY));
+        neg[axis]    = L::ge(L::set(-ACCURACY), L::sub(L::load(hi[axis] + j), c));
+
+        inside &= pos | neg[axis];
+    }
+
+    for (size_t k = 0; k < L::width; ++k)
+    {
+        unsigned child = ((neg[0] >> k) & 1) | (((neg[1] >> k) & 1) << 1) | (((neg[2] >> k) & 1) << 2);
+        slots[j + k] = ((inside >> k) & 1) ? static_cast<uint8_t>(child + 1) : 0;
+    }
+}
+
+}
+
+/**
+ * \brief bit k is set if block[first + k] may intersect the query, num <= BATCH_SIZE.
+ *        Cleared bits are pairs that triangle_t::intersects() rejects, set bits still need the exact test.
+*/
+template <typename real_t>
+uint64_t filter_mask(const basic_query_t<real_t> &query, const basic_triag_block_t<real_t> &block, size_t first, size_t num)
+{
+    using L = lanes_t<real_t>;
+
+    filter_thr_t thr = filter_thr_t::make(query, block);
+
+    uint64_t mask = 0;
+    size_t k = 0;
+
+    for (; k + L::width <= num; k += L::width)
+        mask |= static_cast<uint64_t>(detail::may_intersect<L>(query, block, first + k, thr)) << k;
+
+    for (; k < num; ++k)
+        mask |= static_cast<uint64_t>(detail::may_intersect<scalar_lanes_t<real_t>>(query, block, first + k, thr)) << k;
+
+    return mask;
+}
+
+/**
+ * \brief bit k is set if the bounding boxes of the query and block[first + k] meet, num <= BATCH_SIZE.
+ *        The compared boxes hold the exact ones, so it filters for triangle_t::intersects_exact() too
+*/
+template <typename real_t>
+uint64_t box_mask(const basic_query_t<real_t> &query, const basic_triag_block_t<real_t> &block, size_t first, size_t num)
+{
+    using L = lanes_t<real_t>;
+
+    uint64_t mask = 0;
+    size_t k = 0;
+
+    for (; k + L::width <= num; k += L::width)
+        mask |= static_cast<uint64_t>(detail::boxes_meet<L>(query, block, first + k)) << k;
+
+    for (; k < num; ++k)
+        mask |= static_cast<uint64_t>(detail::boxes_meet<scalar_lanes_t<real_t>>(query, block, first + k)) << k;
+
+    return mask;
+}
+
+/**
+ * \brief octree slots of the boxes lo[axis][k], hi[axis][k], k < num, against the cell center: 0 if box k is within ACCURACY of a splitting
+ *        plane, 1 + child otherwise, set bits of child are the negative half-spaces along x, y, z.
+ *        The same as node_classifier_t::check_box(), a box side is compared after subtracting the center
+*/
+inline void child_slots(const std::array<const double*, 3> &lo, const std::array<const double*, 3> &hi, size_t num,
+                        const std::array<double, 3> &center, uint8_t *slots)
+{
+    using L = lanes_t<double>;
+
+    size_t k = 0;
+
+    for (; k + L::width <= num; k += L::width) detail::box_slots<L>(lo, hi, k, center, slots);
+
+    for (; k < num; ++k) detail::box_slots<scalar_lanes_t<double>>(lo, hi, k, center, slots);
+}
+
+/**
+ * \brief bit k is set if the query intersects triag_at(first + k), the filter survivors get the scalar test
+*/
+template <typename real_t, typename F>
+uint64_t hit_mask(const triangle_t &query, const basic_triag_block_t<real_t> &block, size_t first, size_t num, F triag_at)
+{
+    uint64_t mask = filter_mask(basic_query_t<real_t>{query}, block, first, num);
+
+    for (uint64_t rest = mask; rest; rest &= rest - 1)
+    {
+        size_t k = static_cast<size_t>(__builtin_ctzll(rest));
+        if (!query.intersects(triag_at(first + k))) mask &= ~(uint64_t{1} << k);
+    }
+
+    return mask;
+}
+
+}
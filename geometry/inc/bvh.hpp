@@ -0,0 +1,459 @@
+#pragma once
+#include "double_operations.hpp"
+#include "octree.hpp"
+#include "task_pool.hpp"
+#include <algorithm>
+#include <array>
+#include <vector>
+
+
+namespace bvh {
+
+using octrees::index_t;
+using octrees::max_min_crds_t;
+
+const size_t BVH_MIN_LEAF_SIZE   = 2;         // nodes with fewer triags are never split
+const size_t BVH_MAX_LEAF_SIZE   = (1 << 4);  // nodes with more triags are split even if SAH prefers a leaf
+const int    SAH_BIN_NUM         = 16;
+const double SAH_TRAVERSAL_COST  = 1;         // cost of visiting a node relative to one triag test
+const size_t PARALLEL_BVH_SIZE   = (1 << 12); // smaller subtrees are built and traversed by one task
+const size_t REFIT_TASK_SIZE     = (1 << 12); // triag boxes recomputed by one task in refit()
+
+
+namespace detail {
+
+/**
+ * \brief node of the flat bvh, triags of the subtree are triags_[first_, last_),
+ *        children are child_ and child_ + 1, child_ == 0 for a leaf
+*/
+struct node_t
+{
+    max_min_crds_t box_;
+
+    index_t first_ = 0;
+    index_t last_  = 0;
+    index_t child_ = 0;
+
+    bool is_leaf() const { return child_ == 0; }
+
+    index_t triag_num() const { return last_ - first_; }
+};
+
+}
+
+
+/**
+ * \brief bounding volume hierarchy built with binned surface area heuristic. Every triag is stored in exactly one leaf,
+ *        self collision is a dual-tree traversal that tests pairs of leaves with overlapping boxes.
+*/
+class bvh_t
+{
+    octrees::triag_vector       triags_;
+    std::vector<max_min_crds_t> boxes_;
+    std::vector<detail::node_t> nodes_;
+
+    /* permutation of triags_ used only while building */
+    std::vector<index_t>        order_;
+
+    /* position of triags_[i] in the vector given to the constructor, refit() reads new coordinates from there */
+    std::vector<index_t>        source_;
+
+    double                      build_cost_ = 0;
+
+/*==========================================================================*/
+
+    public:
+
+    bvh_t(octrees::triag_vector triags, size_t thread_num = 1) : triags_(std::move(triags))
+    {
+        index_t triag_num = static_cast<index_t>(triags_.size());
+
+        boxes_.resize(triag_num);
+        order_.resize(triag_num);
+
+        for (index_t i = 0; i < triag_num; ++i)
+        {
+            boxes_[i].update(triags_[i].triag);
+            order_[i] = i;
+        }
+
+        detail::node_t root{};
+        root.last_ = triag_num;
+
+        nodes_.push_back(root);
+
+        if (thread_num > 1)
+        {
+            tasks::task_pool_t pool{thread_num};
+            split_parallel(nodes_, 0, pool);
+        }
+        else
+            split(nodes_, 0);
+
+        source_ = order_;
+
+        std::vector<index_t> order_copy{order_};
+        octrees::apply_permutation(triags_, order_);
+        octrees::apply_permutation(boxes_, order_copy);
+
+        std::vector<index_t>{}.swap(order_);
+
+        build_cost_ = sah_cost();
+    }
+
+    size_t node_num() const { return nodes_.size(); }
+
+    /**
+     * \brief keeps the topology and takes new coordinates from triags, which has to be the vector given to the constructor
+     *        with moved vertices. Triag boxes are recomputed in parallel chunks, node boxes in one bottom-up pass.
+    */
+    void refit(const octrees::triag_vector &triags, size_t thread_num = 1)
+    {
+        size_t triag_num = triags_.size();
+        size_t chunk_num = (triag_num + REFIT_TASK_SIZE - 1) / REFIT_TASK_SIZE;
+
+        auto refit_chunk = [this, triag_num, &triags] (size_t c) {
+            for (size_t i = c * REFIT_TASK_SIZE, end = std::min((c + 1) * REFIT_TASK_SIZE, triag_num); i < end; ++i)
+            {
+                triags_[i].triag = triags[source_[i]].triag;
+
+                boxes_[i] = max_min_crds_t{};
+                boxes_[i].update(triags_[i].triag);
+            }
+        };
+
+        if (thread_num > 1)
+        {
+            tasks::task_pool_t pool{thread_num};
+            tasks::run_chunks(&pool, chunk_num, refit_chunk);
+        }
+        else
+            tasks::run_chunks(nullptr, chunk_num, refit_chunk);
+
+        for (size_t idx = nodes_.size(); idx-- > 0;)
+        {
+            detail::node_t &node = nodes_[idx];
+            node.box_ = max_min_crds_t{};
+
+            if (node.is_leaf())
+                for (index_t i = node.first_; i < node.last_; ++i) node.box_.merge(boxes_[i]);
+            else
+            {
+                node.box_.merge(nodes_[node.child_].box_);
+                node.box_.merge(nodes_[node.child_ + 1].box_);
+            }
+        }
+    }
+
+    /**
+     * \brief surface area heuristic cost of the tree: every node costs its area relative to the root times
+     *        SAH_TRAVERSAL_COST for an internal node or the number of triags for a leaf
+    */
+    double sah_cost() const
+    {
+        if (triags_.empty()) return 0;
+
+        double root_area = nodes_[0].box_.get_area();
+        if (!(root_area > 0)) return nodes_[0].triag_num();
+
+        double cost = 0;
+        for (auto &node : nodes_)
+            cost += node.box_.get_area() / root_area * (node.is_leaf() ? node.triag_num() : SAH_TRAVERSAL_COST);
+
+        return cost;
+    }
+
+    /**
+     * \brief sah_cost() relative to the cost right after building, grows as refit() stretches the boxes
+    */
+    double get_degradation() const { return (build_cost_ > 0) ? sah_cost() / build_cost_ : 1; }
+
+    /**
+     * \brief flag mode, answer_t is std::vector<bool> or stats_answer_t
+    */
+    template <typename answer_t>
+    void get_collisions(answer_t &answer) const { self_collisions(0, answer); }
+
+    /**
+     * \brief appends every intersecting pair of ids, pairs are sorted and unique
+    */
+    void get_collisions(octrees::pair_vector &pairs) const { self_collisions(0, pairs); octrees::sort_pairs(pairs); }
+
+    /**
+     * \brief upper levels of the traversal are spawned as tasks, every worker fills its own copy of answer
+    */
+    template <typename answer_t>
+    void get_collisions(answer_t &answer, size_t thread_num) const
+    {
+        if (thread_num <= 1) { get_collisions(answer); return; }
+
+        tasks::task_pool_t pool{thread_num};
+        tasks::task_group_t group;
+
+        std::vector<answer_t> answers = octrees::make_answers(answer, pool.thread_num());
+
+        self_collisions(0, pool, group, answers);
+        pool.wait(group);
+
+        octrees::merge_answers(answers, answer);
+    }
+
+/*==========================================================================*/
+
+    private:
+
+    struct bin_t
+    {
+        max_min_crds_t box;
+        index_t        count = 0;
+    };
+
+    static int get_bin(double center, double lo, double extent)
+    {
+        int bin = static_cast<int>((center - lo) / extent * SAH_BIN_NUM);
+        return std::min(std::max(bin, 0), SAH_BIN_NUM - 1);
+    }
+
+    double get_center(index_t triag, int axis) const
+    {
+        return (boxes_[triag].get_min(axis) + boxes_[triag].get_max(axis)) / 2;
+    }
+
+    /**
+     * \brief fills box of nodes[idx], chooses the cheapest binned split and partitions order_, returns false for a leaf
+    */
+    bool split_node(std::vector<detail::node_t> &nodes, index_t idx)
+    {
+        detail::node_t &node = nodes[idx];
+
+        max_min_crds_t centers{};
+        for (index_t i = node.first_; i < node.last_; ++i)
+        {
+            node.box_.merge(boxes_[order_[i]]);
+            centers.update(get_center(order_[i], 0), get_center(order_[i], 1), get_center(order_[i], 2));
+        }
+
+        index_t triag_num = node.triag_num();
+        if (triag_num < BVH_MIN_LEAF_SIZE) return false;
+
+        double parent_area = node.box_.get_area();
+
+        int    best_axis = -1, best_bin = 0;
+        double best_cost = std::numeric_limits<double>::infinity();
+
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            double lo = centers.get_min(axis), extent = centers.get_max(axis) - lo;
+            if (!(extent > 0)) continue;
+
+            std::array<bin_t, SAH_BIN_NUM> bins;
+            for (index_t i = node.first_; i < node.last_; ++i)
+            {
+                bin_t &bin = bins[get_bin(get_center(order_[i], axis), lo, extent)];
+                bin.box.merge(boxes_[order_[i]]);
+                ++bin.count;
+            }
+
+            std::array<double, SAH_BIN_NUM> right_cost;
+            max_min_crds_t right_box{};
+            index_t right_count = 0;
+
+            for (int b = SAH_BIN_NUM - 1; b > 0; --b)
+            {
+                right_box.merge(bins[b].box);
+                right_count += bins[b].count;
+                right_cost[b] = right_count ? right_box.get_area() * right_count : -1;
+            }
+
+            max_min_crds_t left_box{};
+            index_t left_count = 0;
+
+            for (int b = 0; b < SAH_BIN_NUM - 1; ++b)
+            {
+                left_box.merge(bins[b].box);
+                left_count += bins[b].count;
+
+                if (left_count == 0 || right_cost[b + 1] < 0) continue;
+
+                double cost = left_box.get_area() * left_count + right_cost[b + 1];
+                if (cost < best_cost) { best_cost = cost; best_axis = axis; best_bin = b; }
+            }
+        }
+
+        if (best_axis < 0) return false;
+
+        double split_cost = SAH_TRAVERSAL_COST + ((parent_area > 0) ? best_cost / parent_area : triag_num);
+        if (split_cost >= triag_num && triag_num <= BVH_MAX_LEAF_SIZE) return false;
+
+        double lo = centers.get_min(best_axis), extent = centers.get_max(best_axis) - lo;
+
+        auto mid = std::partition(order_.begin() + node.first_, order_.begin() + node.last_, [&] (index_t triag) {
+            return get_bin(get_center(triag, best_axis), lo, extent) <= best_bin;
+        });
+
+        index_t middle = static_cast<index_t>(mid - order_.begin());
+        index_t child  = static_cast<index_t>(nodes.size());
+
+        detail::node_t left{}, right{};
+        left.first_  = node.first_;
+        left.last_   = middle;
+        right.first_ = middle;
+        right.last_  = node.last_;
+
+        node.child_ = child;
+
+        nodes.push_back(left);
+        nodes.push_back(right);
+
+        return true;
+    }
+
+    void split(std::vector<detail::node_t> &nodes, index_t idx)
+    {
+        if (!split_node(nodes, idx)) return;
+
+        index_t child = nodes[idx].child_;
+        split(nodes, child);
+        split(nodes, child + 1);
+    }
+
+    void split_parallel(std::vector<detail::node_t> &nodes, index_t idx, tasks::task_pool_t &pool)
+    {
+        if (!split_node(nodes, idx)) return;
+
+        index_t child = nodes[idx].child_;
+
+        std::array<std::vector<detail::node_t>, 2> subtrees;
+        tasks::task_group_t group;
+
+        for (int i = 0; i < 2; ++i)
+        {
+            subtrees[i].push_back(nodes[child + i]);
+
+            pool.spawn(group, [this, i, &subtrees, &pool] {
+                if (subtrees[i][0].triag_num() < PARALLEL_BVH_SIZE)
+                    split(subtrees[i], 0);
+                else
+                    split_parallel(subtrees[i], 0, pool);
+            });
+        }
+
+        pool.wait(group);
+
+        for (int i = 0; i < 2; ++i)
+            octrees::append_subtree(nodes, child + i, subtrees[i]);
+    }
+
+/*==========================================================================*/
+
+    template <typename answer_t>
+    void self_collisions(index_t idx, answer_t &answer) const
+    {
+        const detail::node_t &node = nodes_[idx];
+
+        if (node.is_leaf()) { leaf_collisions(node, answer); return; }
+
+        self_collisions(node.child_, answer);
+        self_collisions(node.child_ + 1, answer);
+        cross_collisions(node.child_, node.child_ + 1, answer);
+    }
+
+    template <typename answer_t>
+    void cross_collisions(index_t a, index_t b, answer_t &answer) const
+    {
+        const detail::node_t &na = nodes_[a];
+        const detail::node_t &nb = nodes_[b];
+
+        if (!na.box_.overlaps(nb.box_, ACCURACY)) return;
+
+        if (na.is_leaf() && nb.is_leaf()) { range_collisions(na, nb, answer); return; }
+
+        if (na.is_leaf() || (!nb.is_leaf() && nb.box_.get_area() > na.box_.get_area()))
+        {
+            cross_collisions(a, nb.child_, answer);
+            cross_collisions(a, nb.child_ + 1, answer);
+            return;
+        }
+
+        cross_collisions(na.child_, b, answer);
+        cross_collisions(na.child_ + 1, b, answer);
+    }
+
+    template <typename answer_t>
+    void self_collisions(index_t idx, tasks::task_pool_t &pool, tasks::task_group_t &group, std::vector<answer_t> &answers) const
+    {
+        const detail::node_t &node = nodes_[idx];
+
+        if (node.is_leaf() || node.triag_num() < PARALLEL_BVH_SIZE)
+        {
+            pool.spawn(group, [this, idx, &pool, &answers] { self_collisions(idx, answers[pool.worker_id()]); });
+            return;
+        }
+
+        pool.spawn(group, [this, &node, &pool, &group, &answers] { self_collisions(node.child_, pool, group, answers); });
+        pool.spawn(group, [this, &node, &pool, &group, &answers] { self_collisions(node.child_ + 1, pool, group, answers); });
+
+        cross_collisions(node.child_, node.child_ + 1, pool, group, answers);
+    }
+
+    template <typename answer_t>
+    void cross_collisions(index_t a, index_t b, tasks::task_pool_t &pool, tasks::task_group_t &group, std::vector<answer_t> &answers) const
+    {
+        const detail::node_t &na = nodes_[a];
+        const detail::node_t &nb = nodes_[b];
+
+        if (!na.box_.overlaps(nb.box_, ACCURACY)) return;
+
+        if (na.is_leaf() || nb.is_leaf() || na.triag_num() + nb.triag_num() < PARALLEL_BVH_SIZE)
+        {
+            pool.spawn(group, [this, a, b, &pool, &answers] { cross_collisions(a, b, answers[pool.worker_id()]); });
+            return;
+        }
+
+        pool.spawn(group, [this, &na, &nb, a, b, &pool, &group, &answers] {
+            if (nb.box_.get_area() > na.box_.get_area())
+            {
+                cross_collisions(a, nb.child_, pool, group, answers);
+                cross_collisions(a, nb.child_ + 1, pool, group, answers);
+                return;
+            }
+
+            cross_collisions(na.child_, b, pool, group, answers);
+            cross_collisions(na.child_ + 1, b, pool, group, answers);
+        });
+    }
+
+    template <typename answer_t>
+    void leaf_collisions(const detail::node_t &node, answer_t &answer) const
+    {
+        for (index_t i = node.first_; i < node.last_; ++i) {
+            const octrees::triag_id_t &it = triags_[i];
+
+            for (index_t j = i + 1; j < node.last_; ++j) {
+                if (!boxes_[i].overlaps(boxes_[j], ACCURACY)) continue;
+
+                const octrees::triag_id_t &jt = triags_[j];
+
+                octrees::test_pair(it, jt, answer);
+            }
+        }
+    }
+
+    template <typename answer_t>
+    void range_collisions(const detail::node_t &na, const detail::node_t &nb, answer_t &answer) const
+    {
+        for (index_t i = na.first_; i < na.last_; ++i) {
+            const octrees::triag_id_t &it = triags_[i];
+
+            for (index_t j = nb.first_; j < nb.last_; ++j) {
+                if (!boxes_[i].overlaps(boxes_[j], ACCURACY)) continue;
+
+                const octrees::triag_id_t &jt = triags_[j];
+
+                octrees::test_pair(it, jt, answer);
+            }
+        }
+    }
+};
+
+}
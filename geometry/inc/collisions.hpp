@@ -0,0 +1,180 @@
+#pragma once
+#include "octree.hpp"
+#include "sweep_prune.hpp"
+#include "bvh.hpp"
+#include "spatial_hash.hpp"
+#include "linear_octree.hpp"
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+
+namespace collisions {
+
+enum engine_type
+{
+    OCTREE,
+    SAP,
+    BVH,
+    GRID,
+    LINEAR_OCTREE,
+    ENGINE_NUM
+};
+
+const char* const engine_names[ENGINE_NUM] = {"octree", "sap", "bvh", "grid", "linear"};
+
+inline bool get_engine_type(const char *name, engine_type &engine)
+{
+    for (int i = 0; i < ENGINE_NUM; ++i)
+        if (!std::strcmp(name, engine_names[i])) { engine = static_cast<engine_type>(i); return true; }
+
+    return false;
+}
+
+struct engine_params_t
+{
+    size_t   thread_num   = 1;
+    double   loose_factor = 1;
+    size_t   leaf_size    = octrees::SIZE_OF_PART; // octree only, octrees::AUTO_LEAF_SIZE to choose it by sampling
+    unsigned max_depth    = octrees::MAX_DEPTH;
+    bool     float_filter = false;                 // octree only
+
+    octrees::octree_params_t octree_params() const { return {thread_num, loose_factor, leaf_size, max_depth, float_filter}; }
+};
+
+struct phase_times_t
+{
+    double build = 0; // seconds
+    double query = 0;
+};
+
+/*==========================================================================*/
+
+namespace detail {
+
+using clock = std::chrono::steady_clock;
+
+inline double seconds_since(clock::time_point start)
+{
+    return std::chrono::duration<double>(clock::now() - start).count();
+}
+
+template <typename engine_t, typename answer_t, typename... Args>
+phase_times_t run_engine(size_t thread_num, answer_t &answer, Args&&... args)
+{
+    phase_times_t times;
+
+    auto start = clock::now();
+    engine_t engine{std::forward<Args>(args)...};
+    times.build = seconds_since(start);
+
+    start = clock::now();
+    engine.get_collisions(answer, thread_num);
+    times.query = seconds_since(start);
+
+    return times;
+}
+
+}
+
+/*==========================================================================*/
+
+/**
+ * \brief finds intersecting triags using the chosen broad phase. answer is either std::vector<bool>
+ *        where answer[id] is marked for every triag that intersects another one (it has to be sized by the caller),
+ *        or octrees::pair_vector that gets every intersecting pair of ids, sorted and unique
+*/
+template <typename answer_t>
+phase_times_t find_collisions(engine_type engine, const octrees::triag_vector &triags, answer_t &answer,
+                              const engine_params_t &params)
+{
+    using namespace octrees;
+
+    switch (engine)
+    {
+        case OCTREE:        return detail::run_engine<octree_t>              (params.thread_num, answer, triags, params.octree_params());
+        case SAP:           return detail::run_engine<sweeps::sap_t>         (params.thread_num, answer, triags);
+        case BVH:           return detail::run_engine<bvh::bvh_t>            (params.thread_num, answer, triags, params.thread_num);
+        case GRID:          return detail::run_engine<grids::spatial_hash_t> (params.thread_num, answer, triags);
+        case LINEAR_OCTREE: return detail::run_engine<linear_octree_t>       (params.thread_num, answer, triags, params.thread_num);
+        default:            break;
+    }
+
+    return {};
+}
+
+/*==========================================================================*/
+
+struct frame_stats_t
+{
+    bool   rebuilt         = false; // the tree was built from scratch in this frame instead of refit
+    double update          = 0;     // seconds spent on build or refit
+    double query           = 0;
+    double degradation     = 1;     // bvh_t::get_degradation() after the update
+    bool   rebuild_cheaper = false; // estimated time lost on the refit tree since the last build exceeds the build time
+};
+
+/**
+ * \brief collisions of a deforming mesh frame by frame: the triag set stays the same and only vertices move.
+ *        The bvh is refit every frame. A refit tree is assumed to lose the query time of the build frame
+ *        times (degradation - 1) per frame, once the sum exceeds the build time the next frame rebuilds the tree.
+*/
+class deforming_scene_t
+{
+    size_t                      thread_num_;
+    std::unique_ptr<bvh::bvh_t> bvh_;
+
+    double build_time_   = 0;
+    double build_query_  = 0; // query time of the frame that built the tree
+    double lost_time_    = 0;
+    bool   rebuild_next_ = true;
+
+    public:
+
+    deforming_scene_t(size_t thread_num = 1) : thread_num_(thread_num) {}
+
+    /**
+     * \brief triags have to keep their count and order between frames, answer is sized by the caller
+    */
+    frame_stats_t frame(const octrees::triag_vector &triags, std::vector<bool> &answer)
+    {
+        frame_stats_t stats;
+
+        auto start = detail::clock::now();
+
+        if (rebuild_next_ || !bvh_)
+        {
+            bvh_ = std::make_unique<bvh::bvh_t>(triags, thread_num_);
+
+            build_time_   = detail::seconds_since(start);
+            lost_time_    = 0;
+            rebuild_next_ = false;
+
+            stats.rebuilt = true;
+            stats.update  = build_time_;
+        }
+        else
+        {
+            bvh_->refit(triags, thread_num_);
+            stats.update = detail::seconds_since(start);
+        }
+
+        stats.degradation = bvh_->get_degradation();
+
+        start = detail::clock::now();
+        bvh_->get_collisions(answer, thread_num_);
+        stats.query = detail::seconds_since(start);
+
+        if (stats.rebuilt)
+            build_query_ = stats.query;
+        else
+            lost_time_ += build_query_ * std::max(stats.degradation - 1, 0.0);
+
+        stats.rebuild_cheaper = rebuild_next_ = (lost_time_ > build_time_);
+
+        return stats;
+    }
+};
+
+}
@@ -1,19 +1,25 @@
 #pragma once
+#include <cstdlib>
 #include <iostream>
 
 namespace custom_assert {
 
+/**
+ * \brief out of line and cold, so an inlined check costs a compare and a branch and not the message printing
+*/
+[[noreturn]] __attribute__((cold, noinline)) inline void fail(const char *cond, int line, const char *func, const char *file)
+{
+    std::cout << "\nError in " << cond
+    << " in line "     << line
+    << " in function " << func
+    << " in file "     << file << "\n\n";
+    abort();
+}
+
 #ifndef RELEASE
 
-#define ASSERT(cond)                      \
-if (!(cond))                               \
-{                                           \
-    std::cout << "\nError in " << #cond      \
-    << " in line "     << __LINE__            \
-    << " in function " << __PRETTY_FUNCTION__  \
-    << " in file "     << __FILE__ << "\n\n";   \
-    abort();                                     \
-}
+#define ASSERT(cond) \
+if (!(cond)) custom_assert::fail(#cond, __LINE__, __PRETTY_FUNCTION__, __FILE__)
 #endif
 
 #ifdef RELEASE
@@ -5,17 +5,52 @@
 
 namespace doperations {
 
-const double ACCURACY = 0.00001;
+/**
+ * \brief absolute tolerance of the comparisons of the geometry classes over real_t. A float keeps about 7 digits,
+ *        its plane distances of coordinates up to about 10^2 are off by a few 10^-5, so its tolerance is 10 times ACCURACY
+*/
+template <typename real_t>
+struct accuracy;
 
-inline bool is_equal(double num1,  double num2) { return (std::abs(num1 - num2) < ACCURACY); }
+template <>
+struct accuracy<double> { static constexpr double value = 0.00001; };
 
-inline double triple_min(double num1, double num2, double num3) { return std::min(std::min(num1, num2), num3); }
-inline double triple_max(double num1, double num2, double num3) { return std::max(std::max(num1, num2), num3); }
+template <>
+struct accuracy<float> { static constexpr float value = 0.0001f; };
 
-inline bool gr_or_eq(double num1, double num2) { return num1 > num2 || is_equal(num1, num2); }
-inline bool ls_or_eq(double num1, double num2) { return num1 < num2 || is_equal(num1, num2); }
+constexpr double ACCURACY = accuracy<double>::value;
 
-inline bool all_positive(double num1, double num2, double num3)
+/* the type of the first argument is taken for the other ones, so literals like 0 convert to it */
+template <typename T>
+struct same_type { using type = T; };
+
+template <typename real_t>
+using same_t = typename same_type<real_t>::type;
+
+/* std::abs and std::isfinite are not constexpr in C++17, these are. __builtin_isfinite is a bit test like std::isfinite */
+template <typename real_t>
+constexpr real_t abs_val(real_t num) { return (num < 0) ? -num : num; }
+
+template <typename real_t>
+constexpr bool is_finite(real_t num) { return __builtin_isfinite(num); }
+
+template <typename real_t>
+constexpr bool is_equal(real_t num1, same_t<real_t> num2) { return (abs_val(num1 - num2) < accuracy<real_t>::value); }
+
+template <typename real_t>
+constexpr real_t triple_min(real_t num1, same_t<real_t> num2, same_t<real_t> num3) { return std::min(std::min(num1, num2), num3); }
+
+template <typename real_t>
+constexpr real_t triple_max(real_t num1, same_t<real_t> num2, same_t<real_t> num3) { return std::max(std::max(num1, num2), num3); }
+
+template <typename real_t>
+constexpr bool gr_or_eq(real_t num1, same_t<real_t> num2) { return num1 > num2 || is_equal(num1, num2); }
+
+template <typename real_t>
+constexpr bool ls_or_eq(real_t num1, same_t<real_t> num2) { return num1 < num2 || is_equal(num1, num2); }
+
+template <typename real_t>
+constexpr bool all_positive(real_t num1, same_t<real_t> num2, same_t<real_t> num3)
 {
     if (is_equal(num1, 0)) num1 = 0;
     if (is_equal(num2, 0)) num2 = 0;
@@ -24,7 +59,8 @@ inline bool all_positive(double num1, double num2, double num3)
     return (num1 > 0) && (num2 > 0) && (num3 > 0);
 }
 
-inline bool all_negative(double num1, double num2, double num3)
+template <typename real_t>
+constexpr bool all_negative(real_t num1, same_t<real_t> num2, same_t<real_t> num3)
 {
     if (is_equal(num1, 0)) num1 = 0;
     if (is_equal(num2, 0)) num2 = 0;
@@ -33,7 +69,8 @@ inline bool all_negative(double num1, double num2, double num3)
     return (num1 < 0) && (num2 < 0) && (num3 < 0);
 }
 
-inline bool all_positive_triag_special(double num1, double num2, double num3)
+template <typename real_t>
+constexpr bool all_positive_triag_special(real_t num1, same_t<real_t> num2, same_t<real_t> num3)
 {
     if (is_equal(num1, 0)) num1 = 0;
     if (is_equal(num2, 0)) num2 = 0;
@@ -53,7 +90,8 @@ inline bool all_positive_triag_special(double num1, double num2, double num3)
     return true;
 }
 
-inline bool all_negative_triag_special(double num1, double num2, double num3)
+template <typename real_t>
+constexpr bool all_negative_triag_special(real_t num1, same_t<real_t> num2, same_t<real_t> num3)
 {
     if (is_equal(num1, 0)) num1 = 0;
     if (is_equal(num2, 0)) num2 = 0;
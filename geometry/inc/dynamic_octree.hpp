@@ -0,0 +1,477 @@
+#pragma once
+#include "custom_assert.hpp"
+#include "double_operations.hpp"
+#include "octree.hpp"
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+
+namespace octrees {
+
+const size_t DYNAMIC_LEAF_SIZE = (1 << 4); // leaves with this many triags are split
+const index_t NO_NODE = std::numeric_limits<index_t>::max();
+
+
+namespace detail {
+
+/**
+ * \brief node of the dynamic octree, triags_ are the border triags of an internal node or all triags of a leaf.
+ *        Children are child_num consecutive nodes starting from child_, child_ == 0 for a leaf.
+*/
+struct dynamic_node_t
+{
+    node_position pos_{0, 0, 0, 0};
+
+    index_t  parent_  = NO_NODE;
+    index_t  child_   = 0;
+    index_t  num_     = 0; // triags in the subtree
+    unsigned depth_   = 0;
+
+    std::vector<triag_id_t> triags_;
+
+    bool is_leaf() const { return child_ == 0; }
+};
+
+/**
+ * \brief where triag id is stored and which triags it intersects, node_ == NO_NODE for an absent id
+*/
+struct dynamic_slot_t
+{
+    index_t node_ = NO_NODE;
+    index_t pos_  = 0;
+
+    std::vector<index_t> partners_;
+};
+
+}
+
+
+/**
+ * \brief octree that is changed by single triags. A triag is kept in the deepest node whose center planes do not cut it,
+ *        so every triag that may intersect it lies either on the path from the root to its node or in the subtree of the node.
+ *        Intersecting pairs are kept per triag, an edit retests only the triag against this neighbourhood.
+ *        Leaves are split when they reach leaf_size triags, subtrees are collapsed when they drop below leaf_size / 2.
+ *        Every triag lies inside the root cube at least ACCURACY away from its faces: an insert outside of it doubles
+ *        the root until it fits, the old root becoming one of the children. The root never shrinks back.
+*/
+class dynamic_octree_t
+{
+    std::vector<detail::dynamic_node_t> nodes_;
+    std::vector<detail::dynamic_slot_t> slots_;
+
+    /* first nodes of freed blocks of children */
+    std::vector<index_t> free_blocks_;
+
+    size_t   leaf_size_     = DYNAMIC_LEAF_SIZE;
+    unsigned max_depth_     = MAX_DEPTH;
+    size_t   triag_num_     = 0;
+    size_t   colliding_num_ = 0;
+
+/*==========================================================================*/
+
+    public:
+
+    /**
+     * \brief root cube is the bounding cube of triags, an empty tree takes the cube of the first inserted triag
+    */
+    dynamic_octree_t(const triag_vector &triags = {}, size_t leaf_size = DYNAMIC_LEAF_SIZE, unsigned max_depth = MAX_DEPTH) :
+    leaf_size_(std::max<size_t>(leaf_size, 2)), max_depth_(max_depth)
+    {
+        max_min_crds_t min_max{};
+        for (auto &triag : triags) min_max.update(triag.triag);
+
+        nodes_.emplace_back();
+        if (!triags.empty()) reset_root(min_max);
+
+        for (auto &triag : triags) insert(triag);
+    }
+
+    /**
+     * \brief adds triag and finds its intersections, returns false if triag.id is already in the tree
+    */
+    bool insert(const triag_id_t &triag)
+    {
+        if (contains(triag.id)) return false;
+        if (slots_.size() <= triag.id) slots_.resize(triag.id + 1);
+
+        fit_root(triag.triag);
+
+        std::vector<index_t> partners;
+        find_partners(triag, partners);
+
+        for (index_t partner : partners) add_partner(partner, static_cast<index_t>(triag.id));
+
+        slots_[triag.id].partners_ = std::move(partners);
+        if (!slots_[triag.id].partners_.empty()) ++colliding_num_;
+
+        place(triag);
+        ++triag_num_;
+
+        return true;
+    }
+
+    /**
+     * \brief removes triag id and its intersections, returns false if there is no such triag
+    */
+    bool erase(size_t id)
+    {
+        if (!contains(id)) return false;
+
+        detail::dynamic_slot_t &slot = slots_[id];
+
+        for (index_t partner : slot.partners_) remove_partner(partner, static_cast<index_t>(id));
+
+        if (!slot.partners_.empty()) --colliding_num_;
+        std::vector<index_t>{}.swap(slot.partners_);
+
+        unplace(id);
+        --triag_num_;
+
+        return true;
+    }
+
+    /**
+     * \brief moves triag id to new coordinates, returns false if there is no such triag
+    */
+    bool update(size_t id, const triangle_t &triag)
+    {
+        if (!erase(id)) return false;
+
+        return insert({triag, id});
+    }
+
+    bool contains(size_t id) const { return id < slots_.size() && slots_[id].node_ != NO_NODE; }
+
+    bool is_colliding(size_t id) const { return contains(id) && !slots_[id].partners_.empty(); }
+
+    /**
+     * \brief ids of the triags that intersect triag id
+    */
+    const std::vector<index_t>& partners(size_t id) const { return slots_[id].partners_; }
+
+    size_t triag_num() const { return triag_num_; }
+
+    size_t colliding_num() const { return colliding_num_; }
+
+    size_t node_num() const { return nodes_.size() - free_blocks_.size() * child_num; }
+
+    const node_position& root_pos() const { return nodes_[0].pos_; }
+
+    /**
+     * \brief marks answer[id] for every colliding triag, answer has to be sized by the caller
+    */
+    void get_collisions(std::vector<bool> &answer) const
+    {
+        for (size_t id = 0, num = slots_.size(); id < num; ++id)
+            if (!slots_[id].partners_.empty()) answer[id] = true;
+    }
+
+    /**
+     * \brief appends every intersecting pair of ids, pairs are sorted and unique
+    */
+    void get_collisions(pair_vector &pairs) const
+    {
+        for (size_t id = 0, num = slots_.size(); id < num; ++id)
+            for (index_t partner : slots_[id].partners_)
+                if (id < partner) pairs.emplace_back(static_cast<index_t>(id), partner);
+
+        sort_pairs(pairs);
+    }
+
+/*==========================================================================*/
+
+    private:
+
+    void add_partner(index_t id, index_t partner)
+    {
+        std::vector<index_t> &partners = slots_[id].partners_;
+
+        if (partners.empty()) ++colliding_num_;
+        partners.push_back(partner);
+    }
+
+    void remove_partner(index_t id, index_t partner)
+    {
+        std::vector<index_t> &partners = slots_[id].partners_;
+
+        auto it = std::find(partners.begin(), partners.end(), partner);
+        ASSERT(it != partners.end());
+
+        *it = partners.back();
+        partners.pop_back();
+
+        if (partners.empty()) --colliding_num_;
+    }
+
+    void test_node(const triag_id_t &triag, index_t idx, std::vector<index_t> &partners) const
+    {
+        for (auto &other : nodes_[idx].triags_)
+            if (triag.triag.intersects(other.triag)) partners.push_back(static_cast<index_t>(other.id));
+    }
+
+    void test_subtree(const triag_id_t &triag, index_t idx, std::vector<index_t> &partners) const
+    {
+        test_node(triag, idx, partners);
+
+        const detail::dynamic_node_t &node = nodes_[idx];
+        if (node.is_leaf() || node.num_ == node.triags_.size()) return;
+
+        for (int i = 0; i < child_num; ++i) test_subtree(triag, node.child_ + i, partners);
+    }
+
+    /**
+     * \brief tests triag with the triags on its path from the root and with the subtree where its descent stops
+    */
+    void find_partners(const triag_id_t &triag, std::vector<index_t> &partners) const
+    {
+        index_t idx = 0;
+
+        while (true)
+        {
+            const detail::dynamic_node_t &node = nodes_[idx];
+
+            if (node.is_leaf()) { test_node(triag, idx, partners); return; }
+
+            cube_positions pos = detail::node_classifier_t{node.pos_}.check_triangle(triag.triag);
+
+            if (pos == BORDER) { test_subtree(triag, idx, partners); return; }
+
+            test_node(triag, idx, partners);
+            idx = node.child_ + pos;
+        }
+    }
+
+/*==========================================================================*/
+
+    bool in_root(const max_min_crds_t &box) const
+    {
+        const node_position &pos = nodes_[0].pos_;
+        const double center[3] = {pos.x_, pos.y_, pos.z_};
+
+        for (int axis = 0; axis < 3; ++axis)
+            if (box.get_min(axis) < center[axis] - pos.rad_ + ACCURACY || box.get_max(axis) > center[axis] + pos.rad_ - ACCURACY)
+                return false;
+
+        return true;
+    }
+
+    /**
+     * \brief the root of an empty tree becomes the bounding cube of box with a margin of 2 * ACCURACY
+    */
+    void reset_root(const max_min_crds_t &box)
+    {
+        nodes_.resize(1);
+        free_blocks_.clear();
+
+        detail::dynamic_node_t &root = nodes_[0];
+
+        root.pos_   = {box.get_meanx(), box.get_meany(), box.get_meanz(), box.get_rad() + 2 * ACCURACY};
+        root.child_ = 0;
+        root.num_   = 0;
+        root.triags_.clear();
+    }
+
+    void fit_root(const triangle_t &triag)
+    {
+        max_min_crds_t box{};
+        box.update(triag);
+
+        if (triag_num_ == 0 && !in_root(box)) { reset_root(box); return; }
+
+        while (!in_root(box)) grow_root(box);
+    }
+
+    void add_depth(index_t idx)
+    {
+        ++nodes_[idx].depth_;
+
+        if (!nodes_[idx].is_leaf())
+            for (int i = 0; i < child_num; ++i) add_depth(nodes_[idx].child_ + i);
+    }
+
+    /**
+     * \brief doubles the root towards box, the old root moves into the child block of the new one with its subtree
+    */
+    void grow_root(const max_min_crds_t &box)
+    {
+        node_position old_pos = nodes_[0].pos_;
+        double rad = old_pos.rad_;
+
+        /* the old root is the child on the side away from the box along every axis */
+        int slot = 0;
+        double center[3] = {old_pos.x_, old_pos.y_, old_pos.z_};
+        const double box_center[3] = {box.get_meanx(), box.get_meany(), box.get_meanz()};
+
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            if (box_center[axis] >= center[axis]) { center[axis] += rad; slot |= (1 << axis); }
+            else                                    center[axis] -= rad;
+        }
+
+        detail::dynamic_node_t old_root = std::move(nodes_[0]);
+
+        nodes_[0] = detail::dynamic_node_t{};
+        nodes_[0].pos_ = {center[0], center[1], center[2], 2 * rad};
+        nodes_[0].num_ = old_root.num_;
+
+        index_t child = alloc_children(0);
+        index_t moved = child + slot;
+
+        nodes_[0].child_ = child;
+
+        old_root.parent_ = 0;
+        nodes_[moved] = std::move(old_root);
+
+        detail::dynamic_node_t &node = nodes_[moved];
+
+        for (auto &triag : node.triags_) slots_[triag.id].node_ = moved;
+
+        if (!node.is_leaf())
+            for (int i = 0; i < child_num; ++i) nodes_[node.child_ + i].parent_ = moved;
+
+        add_depth(moved);
+    }
+
+    void push_triag(index_t idx, const triag_id_t &triag)
+    {
+        detail::dynamic_slot_t &slot = slots_[triag.id];
+
+        slot.node_ = idx;
+        slot.pos_  = static_cast<index_t>(nodes_[idx].triags_.size());
+
+        nodes_[idx].triags_.push_back(triag);
+    }
+
+    /**
+     * \brief puts triag into the deepest node that holds it, the leaf it gets into is split when it is full
+    */
+    void place(const triag_id_t &triag)
+    {
+        index_t idx = 0;
+
+        while (true)
+        {
+            ++nodes_[idx].num_;
+
+            if (nodes_[idx].is_leaf())
+            {
+                push_triag(idx, triag);
+                if (nodes_[idx].triags_.size() >= leaf_size_) split_leaf(idx);
+
+                return;
+            }
+
+            cube_positions pos = detail::node_classifier_t{nodes_[idx].pos_}.check_triangle(triag.triag);
+
+            if (pos == BORDER) { push_triag(idx, triag); return; }
+
+            idx = nodes_[idx].child_ + pos;
+        }
+    }
+
+    index_t alloc_children(index_t parent)
+    {
+        index_t child;
+
+        if (!free_blocks_.empty())
+        {
+            child = free_blocks_.back();
+            free_blocks_.pop_back();
+        }
+        else
+        {
+            child = static_cast<index_t>(nodes_.size());
+            nodes_.resize(nodes_.size() + child_num);
+        }
+
+        for (int i = 0; i < child_num; ++i)
+        {
+            detail::dynamic_node_t &node = nodes_[child + i];
+
+            node.pos_    = nodes_[parent].pos_.child_pos(i);
+            node.parent_ = parent;
+            node.child_  = 0;
+            node.num_    = 0;
+            node.depth_  = nodes_[parent].depth_ + 1;
+            node.triags_.clear();
+        }
+
+        return child;
+    }
+
+    /**
+     * \brief moves the triags of leaf idx that are not cut by its center planes into new children
+    */
+    void split_leaf(index_t idx)
+    {
+        if (nodes_[idx].depth_ >= max_depth_) return;
+
+        index_t child = alloc_children(idx);
+        nodes_[idx].child_ = child;
+
+        std::vector<triag_id_t> triags;
+        triags.swap(nodes_[idx].triags_);
+
+        detail::node_classifier_t classifier{nodes_[idx].pos_};
+
+        for (auto &triag : triags)
+        {
+            cube_positions pos = classifier.check_triangle(triag.triag);
+
+            if (pos == BORDER) { push_triag(idx, triag); continue; }
+
+            ++nodes_[child + pos].num_;
+            push_triag(child + pos, triag);
+        }
+
+        for (int i = 0; i < child_num; ++i)
+            if (nodes_[child + i].triags_.size() >= leaf_size_) split_leaf(child + i);
+    }
+
+    /**
+     * \brief removes triag id from its node and collapses the highest ancestor whose subtree got too small
+    */
+    void unplace(size_t id)
+    {
+        detail::dynamic_slot_t &slot = slots_[id];
+        std::vector<triag_id_t> &triags = nodes_[slot.node_].triags_;
+
+        triags[slot.pos_] = triags.back();
+        slots_[triags[slot.pos_].id].pos_ = slot.pos_;
+        triags.pop_back();
+
+        index_t collapse = NO_NODE;
+
+        for (index_t idx = slot.node_; idx != NO_NODE; idx = nodes_[idx].parent_)
+        {
+            --nodes_[idx].num_;
+            if (!nodes_[idx].is_leaf() && nodes_[idx].num_ < leaf_size_ / 2) collapse = idx;
+        }
+
+        slot.node_ = NO_NODE;
+
+        if (collapse != NO_NODE) collapse_node(collapse);
+    }
+
+    /**
+     * \brief moves all triags of the subtree into node idx and frees the children
+    */
+    void collapse_node(index_t idx)
+    {
+        index_t child = nodes_[idx].child_;
+        nodes_[idx].child_ = 0;
+
+        for (int i = 0; i < child_num; ++i)
+        {
+            if (!nodes_[child + i].is_leaf()) collapse_node(child + i);
+
+            for (auto &triag : nodes_[child + i].triags_) push_triag(idx, triag);
+            std::vector<triag_id_t>{}.swap(nodes_[child + i].triags_);
+        }
+
+        free_blocks_.push_back(child);
+    }
+};
+
+}
@@ -0,0 +1,250 @@
+#pragma once
+
+#include "double_operations.hpp"
+#include "predicates.hpp"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+
+/**
+ * \brief triag intersection test built only on predicates::orient2d() and orient3d(). pnt_t is point_t or int_point_t,
+ *        the predicates are exact for both, so is the test: there is no tolerance and touching counts as intersecting
+*/
+namespace exact {
+
+using predicates::orient2d;
+using predicates::orient3d;
+
+namespace detail {
+
+/**
+ * \brief what the three vertices exactly are: vert_num is 3 for a triag with nonzero area, 2 for a segment
+ *        from pnts[0] to pnts[1] and 1 for a point. A triag keeps its area in the projection that drops axis
+*/
+template <typename pnt_t>
+struct shape_t
+{
+    pnt_t pnts[3];
+    int vert_num;
+    int axis;
+};
+
+template <typename pnt_t>
+using crd_t = decltype(std::declval<pnt_t>().get_x());
+
+template <typename crd_type>
+struct pnt2_t
+{
+    crd_type x, y;
+};
+
+template <typename pnt_t>
+pnt2_t<crd_t<pnt_t>> project(const pnt_t &pnt, int axis)
+{
+    switch (axis)
+    {
+        case 0:  return {pnt.get_y(), pnt.get_z()};
+        case 1:  return {pnt.get_z(), pnt.get_x()};
+        default: return {pnt.get_x(), pnt.get_y()};
+    }
+}
+
+template <typename crd_type>
+int orient(const pnt2_t<crd_type> &a, const pnt2_t<crd_type> &b, const pnt2_t<crd_type> &c)
+{
+    return orient2d(a.x, a.y, b.x, b.y, c.x, c.y);
+}
+
+template <typename crd_type>
+bool in_box(const pnt2_t<crd_type> &a, const pnt2_t<crd_type> &b, const pnt2_t<crd_type> &pnt)
+{
+    return std::min(a.x, b.x) <= pnt.x && pnt.x <= std::max(a.x, b.x) &&
+           std::min(a.y, b.y) <= pnt.y && pnt.y <= std::max(a.y, b.y);
+}
+
+template <typename pnt_t>
+bool lex_less(const pnt_t &pnt1, const pnt_t &pnt2)
+{
+    if (pnt1.get_x() != pnt2.get_x()) return pnt1.get_x() < pnt2.get_x();
+    if (pnt1.get_y() != pnt2.get_y()) return pnt1.get_y() < pnt2.get_y();
+    return pnt1.get_z() < pnt2.get_z();
+}
+
+template <typename pnt_t>
+shape_t<pnt_t> get_shape(const pnt_t &A, const pnt_t &B, const pnt_t &C)
+{
+    shape_t<pnt_t> shape{{A, B, C}, 3, 2};
+
+    /* the largest coordinate of the normal goes first, the projection that drops it is the least likely to degenerate */
+    double ux = static_cast<double>(B.get_x() - A.get_x()), uy = static_cast<double>(B.get_y() - A.get_y()),
+           uz = static_cast<double>(B.get_z() - A.get_z());
+    double vx = static_cast<double>(C.get_x() - A.get_x()), vy = static_cast<double>(C.get_y() - A.get_y()),
+           vz = static_cast<double>(C.get_z() - A.get_z());
+
+    double norm[3] = {std::abs(uy * vz - uz * vy), std::abs(uz * vx - ux * vz), std::abs(ux * vy - uy * vx)};
+
+    int axes[3] = {0, 1, 2};
+    std::sort(axes, axes + 3, [&norm] (int axis1, int axis2) { return norm[axis1] > norm[axis2]; });
+
+    for (int axis : axes)
+        if (orient(project(A, axis), project(B, axis), project(C, axis)) != 0) { shape.axis = axis; return shape; }
+
+    /* collinear vertices, the ends are the smallest and the largest of them in lexicographic order */
+    shape.pnts[0] = std::min({A, B, C}, lex_less<pnt_t>);
+    shape.pnts[1] = std::max({A, B, C}, lex_less<pnt_t>);
+
+    shape.vert_num = (lex_less(shape.pnts[0], shape.pnts[1])) ? 2 : 1;
+
+    return shape;
+}
+
+/**
+ * \brief closed segments, either may be a single point
+*/
+template <typename crd_type>
+bool segments_meet_2d(const pnt2_t<crd_type> &a1, const pnt2_t<crd_type> &b1, const pnt2_t<crd_type> &a2, const pnt2_t<crd_type> &b2)
+{
+    int o1 = orient(a1, b1, a2), o2 = orient(a1, b1, b2);
+    int o3 = orient(a2, b2, a1), o4 = orient(a2, b2, b1);
+
+    if (o1 * o2 < 0 && o3 * o4 < 0) return true;
+
+    return (o1 == 0 && in_box(a1, b1, a2)) || (o2 == 0 && in_box(a1, b1, b2)) ||
+           (o3 == 0 && in_box(a2, b2, a1)) || (o4 == 0 && in_box(a2, b2, b1));
+}
+
+template <typename crd_type>
+bool in_triag_2d(const pnt2_t<crd_type> &a, const pnt2_t<crd_type> &b, const pnt2_t<crd_type> &c, const pnt2_t<crd_type> &pnt)
+{
+    int o1 = orient(a, b, pnt), o2 = orient(b, c, pnt), o3 = orient(c, a, pnt);
+
+    return !((o1 < 0 || o2 < 0 || o3 < 0) && (o1 > 0 || o2 > 0 || o3 > 0));
+}
+
+/**
+ * \brief segment ab lying in the plane of the triag
+*/
+template <typename pnt_t>
+bool triag_meets_segment_2d(const shape_t<pnt_t> &triag, const pnt_t &a, const pnt_t &b)
+{
+    int axis = triag.axis;
+
+    pnt2_t<crd_t<pnt_t>> t[3] = {project(triag.pnts[0], axis), project(triag.pnts[1], axis), project(triag.pnts[2], axis)};
+    pnt2_t<crd_t<pnt_t>> pa = project(a, axis), pb = project(b, axis);
+
+    if (in_triag_2d(t[0], t[1], t[2], pa) || in_triag_2d(t[0], t[1], t[2], pb)) return true;
+
+    for (int i = 0; i < 3; ++i)
+        if (segments_meet_2d(t[i], t[(i + 1) % 3], pa, pb)) return true;
+
+    return false;
+}
+
+template <typename pnt_t>
+bool triag_meets_segment(const shape_t<pnt_t> &triag, const pnt_t &a, const pnt_t &b)
+{
+    const pnt_t *t = triag.pnts;
+
+    int oa = orient3d(t[0], t[1], t[2], a), ob = orient3d(t[0], t[1], t[2], b);
+
+    if (oa * ob > 0) return false;
+    if (oa == 0 && ob == 0) return triag_meets_segment_2d(triag, a, b);
+
+    /* ab reaches the plane, the point where its line crosses it is inside if the line passes all edges on one side */
+    int o1 = orient3d(a, b, t[0], t[1]), o2 = orient3d(a, b, t[1], t[2]), o3 = orient3d(a, b, t[2], t[0]);
+
+    return !((o1 < 0 || o2 < 0 || o3 < 0) && (o1 > 0 || o2 > 0 || o3 > 0));
+}
+
+/**
+ * \brief sides2 are the signs of orient3d() of the vertices of triag2 against the plane of triag1, not all of one sign
+*/
+template <typename pnt_t>
+bool triags_meet(const shape_t<pnt_t> &triag1, const shape_t<pnt_t> &triag2, const int (&sides2)[3])
+{
+    const pnt_t *p = triag1.pnts, *q = triag2.pnts;
+
+    if (sides2[0] == 0 && sides2[1] == 0 && sides2[2] == 0)
+    {
+        for (int i = 0; i < 3; ++i)
+            if (triag_meets_segment_2d(triag1, q[i], q[(i + 1) % 3])) return true;
+
+        /* the only case left is triag1 inside triag2 */
+        int axis = triag1.axis;
+        return in_triag_2d(project(q[0], axis), project(q[1], axis), project(q[2], axis), project(p[0], axis));
+    }
+
+    /* the intersection of triags in crossing planes is a segment whose ends lie on their edges */
+    for (int i = 0; i < 3; ++i)
+        if (triag_meets_segment(triag2, p[i], p[(i + 1) % 3]) || triag_meets_segment(triag1, q[i], q[(i + 1) % 3])) return true;
+
+    return false;
+}
+
+/**
+ * \brief coplanar segments meet iff they meet in all three coordinate projections, one of them keeps their plane undistorted
+*/
+template <typename pnt_t>
+bool segments_meet(const pnt_t &a1, const pnt_t &b1, const pnt_t &a2, const pnt_t &b2)
+{
+    if (orient3d(a1, b1, a2, b2) != 0) return false;
+
+    for (int axis = 0; axis < 3; ++axis)
+        if (!segments_meet_2d(project(a1, axis), project(b1, axis), project(a2, axis), project(b2, axis))) return false;
+
+    return true;
+}
+
+inline bool same_side(const int (&sides)[3])
+{
+    return (sides[0] > 0 && sides[1] > 0 && sides[2] > 0) || (sides[0] < 0 && sides[1] < 0 && sides[2] < 0);
+}
+
+template <typename pnt_t>
+bool boxes_overlap(const pnt_t &A1, const pnt_t &B1, const pnt_t &C1, const pnt_t &A2, const pnt_t &B2, const pnt_t &C2)
+{
+    auto lo = [] (auto a, auto b, auto c) { return std::min(std::min(a, b), c); };
+    auto hi = [] (auto a, auto b, auto c) { return std::max(std::max(a, b), c); };
+
+    return lo(A1.get_x(), B1.get_x(), C1.get_x()) <= hi(A2.get_x(), B2.get_x(), C2.get_x()) &&
+           lo(A2.get_x(), B2.get_x(), C2.get_x()) <= hi(A1.get_x(), B1.get_x(), C1.get_x()) &&
+           lo(A1.get_y(), B1.get_y(), C1.get_y()) <= hi(A2.get_y(), B2.get_y(), C2.get_y()) &&
+           lo(A2.get_y(), B2.get_y(), C2.get_y()) <= hi(A1.get_y(), B1.get_y(), C1.get_y()) &&
+           lo(A1.get_z(), B1.get_z(), C1.get_z()) <= hi(A2.get_z(), B2.get_z(), C2.get_z()) &&
+           lo(A2.get_z(), B2.get_z(), C2.get_z()) <= hi(A1.get_z(), B1.get_z(), C1.get_z());
+}
+
+}
+
+/**
+ * \brief the closed triags A1B1C1 and A2B2C2 have a common point, either may be degenerate
+*/
+template <typename pnt_t>
+bool triags_intersect(const pnt_t &A1, const pnt_t &B1, const pnt_t &C1, const pnt_t &A2, const pnt_t &B2, const pnt_t &C2)
+{
+    if (!detail::boxes_overlap(A1, B1, C1, A2, B2, C2)) return false;
+
+    /* most pairs end here: all vertices of one triag are strictly on one side of the plane of the other,
+       a degenerate triag gives zero signs and never ends the test */
+    int sides2[3] = {orient3d(A1, B1, C1, A2), orient3d(A1, B1, C1, B2), orient3d(A1, B1, C1, C2)};
+    if (detail::same_side(sides2)) return false;
+
+    int sides1[3] = {orient3d(A2, B2, C2, A1), orient3d(A2, B2, C2, B1), orient3d(A2, B2, C2, C1)};
+    if (detail::same_side(sides1)) return false;
+
+    detail::shape_t<pnt_t> shape1 = detail::get_shape(A1, B1, C1);
+    detail::shape_t<pnt_t> shape2 = detail::get_shape(A2, B2, C2);
+
+    const pnt_t &a1 = shape1.pnts[0], &b1 = shape1.pnts[shape1.vert_num - 1];
+    const pnt_t &a2 = shape2.pnts[0], &b2 = shape2.pnts[shape2.vert_num - 1];
+
+    if (shape1.vert_num == 3 && shape2.vert_num == 3) return detail::triags_meet(shape1, shape2, sides2);
+
+    if (shape1.vert_num == 3) return detail::triag_meets_segment(shape1, a2, b2);
+    if (shape2.vert_num == 3) return detail::triag_meets_segment(shape2, a1, b1);
+
+    return detail::segments_meet(a1, b1, a2, b2);
+}
+
+}
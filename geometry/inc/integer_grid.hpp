@@ -0,0 +1,301 @@
+#pragma once
+#include "octree.hpp"
+#include "exact_intersection.hpp"
+#include "predicates.hpp"
+#include "task_pool.hpp"
+#include <algorithm>
+#include <array>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+
+namespace grids {
+
+using geometry::int_point_t;
+
+const int64_t MAX_GRID_SCALE = 1000000;   // largest power of ten tried by find_grid_scale()
+const double  GRID_ULPS      = 4;         // a coordinate is on the grid when crd * scale is this many ulps of the node away from it
+const size_t  GRID_TASK_SIZE = (1 << 10); // triags swept by one task in parallel get_collisions()
+
+/**
+ * \brief smallest power of ten s <= MAX_GRID_SCALE such that every coordinate times s is an integer
+ *        below 2^predicates::MAX_INT_BITS by absolute value, 0 if there is none. crd * s may miss the integer
+ *        only by the rounding of reading a decimal like 0.3 and of the product, a few ulps of the integer,
+ *        so snapping to the grid never moves a vertex farther than the input already rounds it
+*/
+inline int64_t find_grid_scale(const octrees::triag_vector &triags)
+{
+    const double limit = std::ldexp(1.0, predicates::MAX_INT_BITS);
+
+    auto on_grid = [limit] (double crd, int64_t scale) {
+        double steps = crd * static_cast<double>(scale);
+        double node  = std::nearbyint(steps);
+
+        return std::abs(steps - node) <= GRID_ULPS * DBL_EPSILON * std::abs(node) && std::abs(node) < limit;
+    };
+
+    for (int64_t scale = 1; scale <= MAX_GRID_SCALE; scale *= 10)
+    {
+        bool fits = true;
+
+        for (size_t i = 0, num = triags.size(); i < num && fits; ++i)
+            for (const point_t &pnt : {triags[i].triag.getA(), triags[i].triag.getB(), triags[i].triag.getC()})
+                fits = fits && on_grid(pnt.get_x(), scale) && on_grid(pnt.get_y(), scale) && on_grid(pnt.get_z(), scale);
+
+        if (fits) return scale;
+    }
+
+    return 0;
+}
+
+
+namespace detail {
+
+inline int_point_t snap(const point_t &pnt, int64_t scale)
+{
+    double step = static_cast<double>(scale);
+
+    return {std::llround(pnt.get_x() * step), std::llround(pnt.get_y() * step), std::llround(pnt.get_z() * step)};
+}
+
+/**
+ * \brief bounds of the boxes on the two axes the sweep does not order by
+*/
+struct side_bounds_t
+{
+    const int64_t *lo1, *hi1, *lo2, *hi2;
+};
+
+/**
+ * \brief bit k is set if box j + k overlaps the query box {lo1, hi1, lo2, hi2} on both axes, 4 boxes at once with AVX2
+*/
+inline unsigned overlap_lanes(const side_bounds_t &bounds, size_t j, const int64_t (&query)[4], size_t num)
+{
+#if defined(__AVX2__)
+    if (num == 4)
+    {
+        auto load = [j] (const int64_t *ptr) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ptr + j)); };
+
+        __m256i apart = _mm256_or_si256(_mm256_cmpgt_epi64(load(bounds.lo1), _mm256_set1_epi64x(query[1])),
+                                        _mm256_cmpgt_epi64(_mm256_set1_epi64x(query[0]), load(bounds.hi1)));
+        apart = _mm256_or_si256(apart, _mm256_cmpgt_epi64(load(bounds.lo2), _mm256_set1_epi64x(query[3])));
+        apart = _mm256_or_si256(apart, _mm256_cmpgt_epi64(_mm256_set1_epi64x(query[2]), load(bounds.hi2)));
+
+        return ~static_cast<unsigned>(_mm256_movemask_pd(_mm256_castsi256_pd(apart))) & 0xF;
+    }
+#endif
+
+    unsigned mask = 0;
+
+    for (size_t k = 0; k < num; ++k)
+    {
+        size_t m = j + k;
+        bool meets = bounds.lo1[m] <= query[1] && query[0] <= bounds.hi1[m] && bounds.lo2[m] <= query[3] && query[2] <= bounds.hi2[m];
+
+        mask |= static_cast<unsigned>(meets) << k;
+    }
+
+    return mask;
+}
+
+inline bool skip(size_t id1, size_t id2, const std::vector<bool> &answer) { return answer[id1] && answer[id2]; }
+
+inline bool skip(size_t, size_t, const octrees::pair_vector &) { return false; }
+
+inline void mark(size_t id1, size_t id2, std::vector<bool> &answer) { answer[id1] = answer[id2] = true; }
+
+inline void mark(size_t id1, size_t id2, octrees::pair_vector &pairs)
+{
+    octrees::index_t a = static_cast<octrees::index_t>(id1), b = static_cast<octrees::index_t>(id2);
+    pairs.emplace_back(std::min(a, b), std::max(a, b));
+}
+
+}
+
+
+/**
+ * \brief sort-and-sweep over triags snapped to an integer grid of step 1 / scale. The boxes, the sweep and
+ *        the narrow phase exact::triags_intersect() all run on int64_t coordinates with int128_t predicates,
+ *        so the answer is exact and does not depend on the machine or on the number of threads
+*/
+class int_sweep_t
+{
+    std::vector<int_point_t> pnts_; // three per triag, in sweep order
+    std::vector<size_t>      ids_;
+
+    /* box bounds on every axis in sweep order, the sweep goes along axis_ */
+    std::array<std::vector<int64_t>, 3> lo_, hi_;
+
+    int axis_ = 0;
+
+/*==========================================================================*/
+
+    static int choose_axis(const std::array<std::vector<int64_t>, 3> &lo, const std::array<std::vector<int64_t>, 3> &hi)
+    {
+        int best = 0;
+        double best_var = -1;
+
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            double sum = 0, sum_sq = 0, num = static_cast<double>(lo[axis].size());
+
+            for (size_t i = 0, size = lo[axis].size(); i < size; ++i)
+            {
+                double center = (static_cast<double>(lo[axis][i]) + static_cast<double>(hi[axis][i])) / 2;
+                sum    += center;
+                sum_sq += center * center;
+            }
+
+            double var = sum_sq / num - (sum / num) * (sum / num);
+            if (var > best_var) { best_var = var; best = axis; }
+        }
+
+        return best;
+    }
+
+    static void finish(std::vector<bool> &) {}
+
+    static void finish(octrees::pair_vector &pairs) { octrees::sort_pairs(pairs); }
+
+    template <typename answer_t>
+    void sweep(size_t begin, size_t end, answer_t &answer) const
+    {
+        int axis1 = (axis_ + 1) % 3, axis2 = (axis_ + 2) % 3;
+
+        detail::side_bounds_t bounds{lo_[axis1].data(), hi_[axis1].data(), lo_[axis2].data(), hi_[axis2].data()};
+
+        const std::vector<int64_t> &lo = lo_[axis_];
+
+        for (size_t i = begin; i < end; ++i)
+        {
+            int64_t query[4] = {lo_[axis1][i], hi_[axis1][i], lo_[axis2][i], hi_[axis2][i]};
+
+            size_t last = static_cast<size_t>(std::upper_bound(lo.begin() + i + 1, lo.end(), hi_[axis_][i]) - lo.begin());
+
+            for (size_t j = i + 1; j < last; j += 4)
+            {
+                size_t num = std::min<size_t>(4, last - j);
+
+                for (unsigned mask = detail::overlap_lanes(bounds, j, query, num); mask; mask &= mask - 1)
+                {
+                    size_t m = j + static_cast<size_t>(__builtin_ctz(mask));
+
+                    if (detail::skip(ids_[i], ids_[m], answer)) continue;
+
+                    const int_point_t *p = &pnts_[3 * i], *q = &pnts_[3 * m];
+                    if (exact::triags_intersect(p[0], p[1], p[2], q[0], q[1], q[2])) detail::mark(ids_[i], ids_[m], answer);
+                }
+            }
+        }
+    }
+
+/*==========================================================================*/
+
+    public:
+
+    /**
+     * \brief scale is a grid that fits the triags, usually the one found by find_grid_scale()
+    */
+    int_sweep_t(const octrees::triag_vector &triags, int64_t scale)
+    {
+        size_t triag_num = triags.size();
+        if (triag_num == 0) return;
+
+        std::vector<int_point_t> pnts(3 * triag_num);
+
+        for (size_t i = 0; i < triag_num; ++i)
+        {
+            const triangle_t &triag = triags[i].triag;
+
+            pnts[3 * i]     = detail::snap(triag.getA(), scale);
+            pnts[3 * i + 1] = detail::snap(triag.getB(), scale);
+            pnts[3 * i + 2] = detail::snap(triag.getC(), scale);
+        }
+
+        auto crd = [] (const int_point_t &pnt, int axis) { return (axis == 0) ? pnt.get_x() : (axis == 1) ? pnt.get_y() : pnt.get_z(); };
+
+        std::array<std::vector<int64_t>, 3> lo, hi;
+
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            lo[axis].resize(triag_num);
+            hi[axis].resize(triag_num);
+
+            for (size_t i = 0; i < triag_num; ++i)
+            {
+                int64_t a = crd(pnts[3 * i], axis), b = crd(pnts[3 * i + 1], axis), c = crd(pnts[3 * i + 2], axis);
+
+                lo[axis][i] = std::min(std::min(a, b), c);
+                hi[axis][i] = std::max(std::max(a, b), c);
+            }
+        }
+
+        axis_ = choose_axis(lo, hi);
+
+        std::vector<size_t> order(triag_num);
+        for (size_t i = 0; i < triag_num; ++i) order[i] = i;
+
+        std::stable_sort(order.begin(), order.end(), [&lo, this] (size_t a, size_t b) { return lo[axis_][a] < lo[axis_][b]; });
+
+        pnts_.resize(3 * triag_num);
+        ids_.resize(triag_num);
+
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            lo_[axis].resize(triag_num);
+            hi_[axis].resize(triag_num);
+        }
+
+        for (size_t i = 0; i < triag_num; ++i)
+        {
+            size_t from = order[i];
+
+            ids_[i] = triags[from].id;
+            for (int v = 0; v < 3; ++v) pnts_[3 * i + v] = pnts[3 * from + v];
+
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                lo_[axis][i] = lo[axis][from];
+                hi_[axis][i] = hi[axis][from];
+            }
+        }
+    }
+
+    int get_axis() const { return axis_; }
+
+    /**
+     * \brief answer_t is std::vector<bool> (flag mode) or pair_vector, pairs are sorted and unique
+    */
+    template <typename answer_t>
+    void get_collisions(answer_t &answer, size_t thread_num = 1) const
+    {
+        size_t triag_num = ids_.size();
+
+        if (thread_num <= 1)
+            sweep(0, triag_num, answer);
+        else
+        {
+            tasks::task_pool_t pool{thread_num};
+
+            std::vector<answer_t> answers = octrees::make_answers(answer, pool.thread_num());
+
+            size_t chunk_num = (triag_num + GRID_TASK_SIZE - 1) / GRID_TASK_SIZE;
+
+            tasks::run_chunks(&pool, chunk_num, [this, triag_num, &pool, &answers] (size_t c) {
+                sweep(c * GRID_TASK_SIZE, std::min((c + 1) * GRID_TASK_SIZE, triag_num), answers[pool.worker_id()]);
+            });
+
+            octrees::merge_answers(answers, answer);
+        }
+
+        finish(answer);
+    }
+};
+
+}
@@ -4,32 +4,108 @@
 
 namespace geometry {
 
-class line_t
+template <typename real_t>
+class basic_line_t
 {
-    vector_t dir_vec_;
-    point_t  line_pnt_;
+    using point_type  = basic_point_t<real_t>;
+    using vector_type = basic_vector_t<real_t>;
 
-    double p1_, p2_, p3_;
+    vector_type dir_vec_;
+    point_type  line_pnt_;
+
+    real_t p1_, p2_, p3_;
 
     public:
 
-    line_t(const vector_t &dir_vec, const point_t &line_pnt) : dir_vec_(dir_vec), line_pnt_(line_pnt), p1_(dir_vec_.get_x()), p2_(dir_vec_.get_y()), p3_(dir_vec_.get_z()) {}
+    constexpr basic_line_t(const vector_type &dir_vec, const point_type &line_pnt) : dir_vec_(dir_vec), line_pnt_(line_pnt), p1_(dir_vec_.get_x()), p2_(dir_vec_.get_y()), p3_(dir_vec_.get_z()) {}
+
+
+    constexpr bool operator== (const basic_line_t &line2) const
+    {
+        return (dir_vec_.vec_product(line2.dir_vec_) == null_vec<real_t>) && check_point_belong(line2.line_pnt_);
+    }
+
+    constexpr bool check_point_belong(const point_type &pnt) const
+    {
+        ASSERT(is_valid());
+        ASSERT(pnt.is_valid());
+
+        real_t t0 = 0;
+        if (!is_equal(p1_, 0))
+            t0 = (pnt.get_x() - line_pnt_.get_x()) / p1_;
+
+        if (!is_equal(p2_, 0))
+            t0 = (pnt.get_y() - line_pnt_.get_y()) / p2_;
+
+        if (!is_equal(p3_, 0))
+            t0 = (pnt.get_z() - line_pnt_.get_z()) / p3_;
+
+        return is_equal(pnt.get_x() - line_pnt_.get_x(), t0 * p1_) &&
+               is_equal(pnt.get_y() - line_pnt_.get_y(), t0 * p2_) &&
+               is_equal(pnt.get_z() - line_pnt_.get_z(), t0 * p3_);
+    }
 
+    constexpr point_type get_line_intersection(const basic_line_t &line2) const
+    {
+        ASSERT(is_valid());
+        ASSERT(line2.is_valid());
 
-    bool operator== (const line_t &line2) const;
+        if ((dir_vec_.vec_product(line2.dir_vec_) == null_vec<real_t>))
+        {
+            if (check_point_belong(line2.line_pnt_)) return spec_pnt<real_t>;
+            return nan_pnt<real_t>;
+        }
 
-    bool check_point_belong(const point_t &pnt) const;
+        /* the common point is at t0 on this line, it is returned only if it is on line2 too */
+        auto common_pnt = [this, &line2] (real_t t0) {
+            point_type pnt{line_pnt_.get_x() + t0 * p1_,
+                           line_pnt_.get_y() + t0 * p2_,
+                           line_pnt_.get_z() + t0 * p3_};
 
-    point_t  get_line_intersection(const line_t &line2) const;
+            return line2.check_point_belong(pnt) ? pnt : nan_pnt<real_t>;
+        };
 
-    point_t  get_line_pnt() const { return line_pnt_; }
+        real_t main_det = p2_ * line2.p1_ - p1_ * line2.p2_;
+        if (!is_equal(main_det, 0))
+        {
+            real_t sub_det = (line2.line_pnt_.get_y() - line_pnt_.get_y()) * line2.p1_ -
+                             (line2.line_pnt_.get_x() - line_pnt_.get_x()) * line2.p2_;
 
-    vector_t get_dir_vec() const { return dir_vec_; }
+            return common_pnt(sub_det / main_det);
+        }
 
-    bool is_valid() const { return dir_vec_.is_valid() && line_pnt_.is_valid(); }
+        main_det = p3_ * line2.p1_ - p1_ * line2.p3_;
+        if (!is_equal(main_det, 0))
+        {
+            real_t sub_det = (line2.line_pnt_.get_z() - line_pnt_.get_z()) * line2.p1_ -
+                             (line2.line_pnt_.get_x() - line_pnt_.get_x()) * line2.p3_;
 
+            return common_pnt(sub_det / main_det);
+        }
 
-    void print() const;
+        main_det = p3_ * line2.p2_ - p2_ * line2.p3_;
+        real_t sub_det = (line2.line_pnt_.get_z() - line_pnt_.get_z()) * line2.p2_ -
+                         (line2.line_pnt_.get_y() - line_pnt_.get_y()) * line2.p3_;
+
+        return common_pnt(sub_det / main_det);
+    }
+
+    constexpr point_type  get_line_pnt() const { return line_pnt_; }
+
+    constexpr const vector_type& get_dir_vec() const { return dir_vec_; }
+
+    constexpr bool is_valid() const { return dir_vec_.is_valid() && line_pnt_.is_valid(); }
+
+
+    void print() const
+    {
+        std::cout << std::endl << "line vec: ";
+        dir_vec_.print();
+        std::cout << "line pnt: ";
+        line_pnt_.print();
+    }
 };
 
+using line_t = basic_line_t<double>;
+
 }
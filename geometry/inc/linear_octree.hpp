@@ -0,0 +1,366 @@
+#pragma once
+#include "double_operations.hpp"
+#include "octree.hpp"
+#include "radix_sort.hpp"
+#include "task_pool.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+
+namespace octrees {
+
+const int    MORTON_BITS          = 21;         // bits of one quantized coordinate, 3 * 21 = 63 bits of a code
+const size_t LINEAR_LEAF_SIZE     = (1 << 4);   // nodes with fewer triags are leaves
+const size_t PARALLEL_LINEAR_SIZE = (1 << 12);  // smaller subtrees are built and traversed by one task
+
+/**
+ * \brief interleaves the lower MORTON_BITS bits of x with two zero bits after each one
+*/
+inline uint64_t spread_bits(uint64_t x)
+{
+    x &= (uint64_t{1} << MORTON_BITS) - 1;
+    x = (x | x << 32) & 0x1f00000000ffffULL;
+    x = (x | x << 16) & 0x1f0000ff0000ffULL;
+    x = (x | x << 8)  & 0x100f00f00f00f00fULL;
+    x = (x | x << 4)  & 0x10c30c30c30c30c3ULL;
+    x = (x | x << 2)  & 0x1249249249249249ULL;
+    return x;
+}
+
+inline uint64_t get_morton_code(uint64_t x, uint64_t y, uint64_t z)
+{
+    return (spread_bits(x) << 2) | (spread_bits(y) << 1) | spread_bits(z);
+}
+
+
+namespace detail {
+
+/**
+ * \brief node of the linear octree, its triags are all_triags_[first_, last_) and share the top 3 * level_ bits
+ *        of their codes. Nonempty children are child_num_ consecutive nodes from child_, child_ == 0 for a leaf.
+*/
+struct linear_node_t
+{
+    max_min_crds_t box_;
+
+    index_t first_ = 0;
+    index_t last_  = 0;
+    index_t child_ = 0;
+
+    uint8_t child_num_ = 0;
+    uint8_t level_     = 0;
+
+    bool is_leaf() const { return child_ == 0; }
+
+    index_t triag_num() const { return last_ - first_; }
+};
+
+}
+
+
+/**
+ * \brief pointerless octree over Morton codes of triag centroids. Codes are sorted by a parallel radix sort and
+ *        every node is a range of the sorted array, children are found by the next 3 bits of the codes.
+ *        A triag may stick out of its cell, so the query walks pairs of sibling subtrees whose tight boxes overlap.
+*/
+class linear_octree_t
+{
+    triag_vector                        all_triags_;
+    std::vector<max_min_crds_t>         boxes_;
+    std::vector<detail::linear_node_t>  nodes_;
+
+    /* sorted codes of all_triags_, used only while building */
+    std::vector<uint64_t>               codes_;
+
+/*==========================================================================*/
+
+    public:
+
+    linear_octree_t(triag_vector all_triags, size_t thread_num = 1) : all_triags_(std::move(all_triags))
+    {
+        index_t triag_num = static_cast<index_t>(all_triags_.size());
+
+        std::unique_ptr<tasks::task_pool_t> pool;
+        if (thread_num > 1) pool = std::make_unique<tasks::task_pool_t>(thread_num);
+
+        calc_codes(pool.get());
+
+        std::vector<index_t> order(triag_num);
+        for (index_t i = 0; i < triag_num; ++i) order[i] = i;
+
+        sorts::radix_sort(codes_, order, pool.get());
+
+        std::vector<index_t> order_copy{order};
+        apply_permutation(all_triags_, order);
+        apply_permutation(boxes_, order_copy);
+
+        detail::linear_node_t root{};
+        root.last_ = triag_num;
+
+        nodes_.push_back(root);
+
+        if (pool) split_parallel(nodes_, 0, *pool);
+        else      split(nodes_, 0);
+
+        std::vector<uint64_t>{}.swap(codes_);
+    }
+
+    size_t node_num() const { return nodes_.size(); }
+
+    /**
+     * \brief flag mode, answer_t is std::vector<bool> or stats_answer_t
+    */
+    template <typename answer_t>
+    void get_collisions(answer_t &answer) const { self_collisions(0, answer); }
+
+    /**
+     * \brief appends every intersecting pair of ids, pairs are sorted and unique
+    */
+    void get_collisions(pair_vector &pairs) const { self_collisions(0, pairs); sort_pairs(pairs); }
+
+    /**
+     * \brief upper levels of the traversal are spawned as tasks, every worker fills its own copy of answer
+    */
+    template <typename answer_t>
+    void get_collisions(answer_t &answer, size_t thread_num) const
+    {
+        if (thread_num <= 1) { get_collisions(answer); return; }
+
+        tasks::task_pool_t pool{thread_num};
+        tasks::task_group_t group;
+
+        std::vector<answer_t> answers = make_answers(answer, pool.thread_num());
+
+        self_collisions(0, pool, group, answers);
+        pool.wait(group);
+
+        merge_answers(answers, answer);
+    }
+
+/*==========================================================================*/
+
+    private:
+
+    /**
+     * \brief boxes and codes of centroids quantized in the bounding cube of the scene
+    */
+    void calc_codes(tasks::task_pool_t *pool)
+    {
+        size_t triag_num = all_triags_.size();
+        size_t chunk_num = (triag_num + PARALLEL_BUILD_SIZE - 1) / PARALLEL_BUILD_SIZE;
+
+        boxes_.resize(triag_num);
+        codes_.resize(triag_num);
+
+        std::vector<max_min_crds_t> chunk_bounds(chunk_num);
+
+        tasks::run_chunks(pool, chunk_num, [this, triag_num, &chunk_bounds] (size_t c) {
+            for (size_t i = c * PARALLEL_BUILD_SIZE, end = std::min((c + 1) * PARALLEL_BUILD_SIZE, triag_num); i < end; ++i)
+            {
+                boxes_[i].update(all_triags_[i].triag);
+                chunk_bounds[c].merge(boxes_[i]);
+            }
+        });
+
+        max_min_crds_t scene{};
+        for (auto &bounds : chunk_bounds) scene.merge(bounds);
+
+        double cube  = 2 * scene.get_rad();
+        double scale = (cube > 0) ? ((uint64_t{1} << MORTON_BITS) - 1) / cube : 0;
+
+        auto quantize = [scale] (double crd, double lo) { return static_cast<uint64_t>((crd - lo) * scale); };
+
+        tasks::run_chunks(pool, chunk_num, [&] (size_t c) {
+            for (size_t i = c * PARALLEL_BUILD_SIZE, end = std::min((c + 1) * PARALLEL_BUILD_SIZE, triag_num); i < end; ++i)
+            {
+                vector_t center = all_triags_[i].triag.get_center_x3();
+
+                codes_[i] = get_morton_code(quantize(center.get_x() / 3, scene.x_min),
+                                            quantize(center.get_y() / 3, scene.y_min),
+                                            quantize(center.get_z() / 3, scene.z_min));
+            }
+        });
+    }
+
+    static int get_digit(uint64_t code, int level)
+    {
+        return static_cast<int>((code >> (3 * (MORTON_BITS - 1 - level))) & 7);
+    }
+
+    /**
+     * \brief fills box of nodes[idx] and appends its nonempty children, returns false for a leaf
+    */
+    bool split_node(std::vector<detail::linear_node_t> &nodes, index_t idx)
+    {
+        detail::linear_node_t node = nodes[idx];
+
+        for (index_t i = node.first_; i < node.last_; ++i) node.box_.merge(boxes_[i]);
+
+        nodes[idx].box_ = node.box_;
+
+        if (node.triag_num() < LINEAR_LEAF_SIZE || node.level_ == MORTON_BITS) return false;
+
+        index_t child = static_cast<index_t>(nodes.size());
+        uint8_t child_num = 0;
+
+        auto begin = codes_.begin() + node.first_;
+        auto end   = codes_.begin() + node.last_;
+
+        for (int digit = 0; digit < 8; ++digit)
+        {
+            auto next = std::partition_point(begin, end, [&node, digit] (uint64_t code) { return get_digit(code, node.level_) <= digit; });
+
+            if (next == begin) continue;
+
+            detail::linear_node_t child_node{};
+            child_node.first_ = static_cast<index_t>(begin - codes_.begin());
+            child_node.last_  = static_cast<index_t>(next  - codes_.begin());
+            child_node.level_ = node.level_ + 1;
+
+            nodes.push_back(child_node);
+            ++child_num;
+
+            begin = next;
+        }
+
+        nodes[idx].child_     = child;
+        nodes[idx].child_num_ = child_num;
+
+        return true;
+    }
+
+    void split(std::vector<detail::linear_node_t> &nodes, index_t idx)
+    {
+        if (!split_node(nodes, idx)) return;
+
+        index_t child = nodes[idx].child_;
+        for (index_t i = 0; i < nodes[idx].child_num_; ++i) split(nodes, child + i);
+    }
+
+    void split_parallel(std::vector<detail::linear_node_t> &nodes, index_t idx, tasks::task_pool_t &pool)
+    {
+        if (!split_node(nodes, idx)) return;
+
+        index_t child     = nodes[idx].child_;
+        index_t child_num = nodes[idx].child_num_;
+
+        std::vector<std::vector<detail::linear_node_t>> subtrees(child_num);
+        tasks::task_group_t group;
+
+        for (index_t i = 0; i < child_num; ++i)
+        {
+            subtrees[i].push_back(nodes[child + i]);
+
+            pool.spawn(group, [this, i, &subtrees, &pool] {
+                if (subtrees[i][0].triag_num() < PARALLEL_LINEAR_SIZE)
+                    split(subtrees[i], 0);
+                else
+                    split_parallel(subtrees[i], 0, pool);
+            });
+        }
+
+        pool.wait(group);
+
+        for (index_t i = 0; i < child_num; ++i)
+            append_subtree(nodes, child + i, subtrees[i]);
+    }
+
+/*==========================================================================*/
+
+    template <typename answer_t>
+    void self_collisions(index_t idx, answer_t &answer) const
+    {
+        const detail::linear_node_t &node = nodes_[idx];
+
+        if (node.is_leaf()) { leaf_collisions(node, answer); return; }
+
+        for (index_t i = 0; i < node.child_num_; ++i)
+            self_collisions(node.child_ + i, answer);
+
+        for (index_t i = 0; i < node.child_num_; ++i)
+            for (index_t j = i + 1; j < node.child_num_; ++j)
+                cross_collisions(node.child_ + i, node.child_ + j, answer);
+    }
+
+    template <typename answer_t>
+    void cross_collisions(index_t a, index_t b, answer_t &answer) const
+    {
+        const detail::linear_node_t &na = nodes_[a];
+        const detail::linear_node_t &nb = nodes_[b];
+
+        if (!na.box_.overlaps(nb.box_, ACCURACY)) return;
+
+        if (na.is_leaf() && nb.is_leaf()) { range_collisions(na, nb, answer); return; }
+
+        if (na.is_leaf() || (!nb.is_leaf() && nb.triag_num() > na.triag_num()))
+        {
+            for (index_t i = 0; i < nb.child_num_; ++i) cross_collisions(a, nb.child_ + i, answer);
+            return;
+        }
+
+        for (index_t i = 0; i < na.child_num_; ++i) cross_collisions(na.child_ + i, b, answer);
+    }
+
+    template <typename answer_t>
+    void self_collisions(index_t idx, tasks::task_pool_t &pool, tasks::task_group_t &group, std::vector<answer_t> &answers) const
+    {
+        const detail::linear_node_t &node = nodes_[idx];
+
+        if (node.is_leaf() || node.triag_num() < PARALLEL_LINEAR_SIZE)
+        {
+            pool.spawn(group, [this, idx, &pool, &answers] { self_collisions(idx, answers[pool.worker_id()]); });
+            return;
+        }
+
+        for (index_t i = 0; i < node.child_num_; ++i)
+        {
+            index_t child = node.child_ + i;
+            pool.spawn(group, [this, child, &pool, &group, &answers] { self_collisions(child, pool, group, answers); });
+        }
+
+        for (index_t i = 0; i < node.child_num_; ++i)
+            for (index_t j = i + 1; j < node.child_num_; ++j)
+            {
+                index_t a = node.child_ + i, b = node.child_ + j;
+                if (nodes_[a].box_.overlaps(nodes_[b].box_, ACCURACY))
+                    pool.spawn(group, [this, a, b, &pool, &answers] { cross_collisions(a, b, answers[pool.worker_id()]); });
+            }
+    }
+
+    template <typename answer_t>
+    void leaf_collisions(const detail::linear_node_t &node, answer_t &answer) const
+    {
+        for (index_t i = node.first_; i < node.last_; ++i) {
+            const triag_id_t &it = all_triags_[i];
+
+            for (index_t j = i + 1; j < node.last_; ++j) {
+                if (!boxes_[i].overlaps(boxes_[j], ACCURACY)) continue;
+
+                const triag_id_t &jt = all_triags_[j];
+
+                test_pair(it, jt, answer);
+            }
+        }
+    }
+
+    template <typename answer_t>
+    void range_collisions(const detail::linear_node_t &na, const detail::linear_node_t &nb, answer_t &answer) const
+    {
+        for (index_t i = na.first_; i < na.last_; ++i) {
+            const triag_id_t &it = all_triags_[i];
+
+            for (index_t j = nb.first_; j < nb.last_; ++j) {
+                if (!boxes_[i].overlaps(boxes_[j], ACCURACY)) continue;
+
+                const triag_id_t &jt = all_triags_[j];
+
+                test_pair(it, jt, answer);
+            }
+        }
+    }
+};
+
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+namespace files {
+
+/**
+ * \brief whole file mapped read-only, pages are loaded by the first access to them
+*/
+class mapped_file_t
+{
+    void   *data_ = MAP_FAILED;
+    size_t  size_ = 0;
+
+    public:
+
+    explicit mapped_file_t(const std::string &path)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) throw std::runtime_error{"can't open " + path};
+
+        struct stat st;
+        if (::fstat(fd, &st) == 0 && st.st_size > 0)
+        {
+            size_ = static_cast<size_t>(st.st_size);
+            data_ = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+
+        ::close(fd);
+
+        if (data_ == MAP_FAILED) throw std::runtime_error{"can't map " + path};
+    }
+
+    mapped_file_t(const mapped_file_t&) = delete;
+    mapped_file_t& operator=(const mapped_file_t&) = delete;
+
+    ~mapped_file_t() { ::munmap(data_, size_); }
+
+    const char* data() const { return static_cast<const char*>(data_); }
+
+    size_t size() const { return size_; }
+};
+
+}
@@ -2,12 +2,23 @@
 #include "double_operations.hpp"
 #include "triangle.hpp"
 #include "plane.hpp"
+#include "task_pool.hpp"
+#include "mapped_file.hpp"
+#include "batch_kernel.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
 #include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
 #include <limits>
 #include <vector>
 #include <array>
-#include <list>
-#include <set>
+#include <cstdint>
+#include <utility>
 
 using namespace doperations;
 using namespace geometry;
@@ -17,6 +28,21 @@ namespace octrees{
 
 const size_t SIZE_OF_PART = (1 << 7);
 const int child_num = 8;
+const size_t BORDER_TASK_SIZE = (1 << 5); // border triags checked by one task in parallel get_collisions()
+const size_t PARALLEL_BUILD_SIZE = (1 << 12); // smaller subtrees and chunks are built by one task
+const unsigned MAX_DEPTH = 32; // nodes this deep are leaves whatever their size
+
+const size_t AUTO_LEAF_SIZE = 0; // leaf size that is chosen by sampling the input
+const size_t AUTO_TUNE_SAMPLE = (1 << 16); // triags in the sample used to choose the leaf size
+const double AUTO_TUNE_NODE_COST = 4; // cost of one node relative to one triag test
+const double AUTO_TUNE_CLASSIFY_COST = 1; // cost of putting a triag into a child relative to one triag test
+
+const size_t QUERY_TASK_SIZE = (1 << 6); // shapes or rays answered by one task in a batch query() or cast_rays()
+
+const uint32_t INDEX_VERSION = 3; // version of the octree index file, files of other versions are rejected
+const size_t INDEX_ALIGN = 64; // arrays in the index file start at multiples of it
+
+using index_t = uint32_t;
 
 struct triag_id_t
 {
@@ -26,20 +52,36 @@ struct triag_id_t
 
 using triag_vector = std::vector<triag_id_t>;
 
-struct node_position
+template <typename real_t>
+struct basic_node_position
 {
-    double x_, y_, z_;
-    double rad_;
+    real_t x_, y_, z_;
+    real_t rad_;
 
-    node_position(double x, double y, double z, double rad) :
+    basic_node_position(real_t x, real_t y, real_t z, real_t rad) :
     x_(x), y_(y), z_(z), rad_(rad){}
 
+    /**
+     * \brief cube of child i, set bits of i are the negative half-spaces along x, y, z
+    */
+    basic_node_position child_pos(int i) const
+    {
+        real_t next_rad = rad_ / 2;
+
+        return {x_ + ((i & (1 << 0)) ? -next_rad : next_rad),
+                y_ + ((i & (1 << 1)) ? -next_rad : next_rad),
+                z_ + ((i & (1 << 2)) ? -next_rad : next_rad),
+                next_rad};
+    }
+
     void print() const
     {
         std::cout << "center = (" << x_ << ", " << y_ << ", " << z_ << ")\nradius = " << rad_ << std::endl;
     }
 };
 
+using node_position = basic_node_position<double>;
+
 
 enum cube_positions
 {
@@ -76,6 +118,46 @@ struct max_min_crds_t
         if (z > z_max) z_max = z;
     }
 
+    void update(const triangle_t &triag)
+    {
+        point_t A{triag.getA()};
+        point_t B{triag.getB()};
+        point_t C{triag.getC()};
+
+        update(A.get_x(), A.get_y(), A.get_z());
+        update(B.get_x(), B.get_y(), B.get_z());
+        update(C.get_x(), C.get_y(), C.get_z());
+    }
+
+    bool overlaps(const max_min_crds_t &other, double eps) const
+    {
+        return x_min <= other.x_max + eps && other.x_min <= x_max + eps &&
+               y_min <= other.y_max + eps && other.y_min <= y_max + eps &&
+               z_min <= other.z_max + eps && other.z_min <= z_max + eps;
+    }
+
+    void merge(const max_min_crds_t &other)
+    {
+        x_min = std::min(x_min, other.x_min);
+        x_max = std::max(x_max, other.x_max);
+        y_min = std::min(y_min, other.y_min);
+        y_max = std::max(y_max, other.y_max);
+        z_min = std::min(z_min, other.z_min);
+        z_max = std::max(z_max, other.z_max);
+    }
+
+    /**
+     * \brief half of the surface area of the box, enough for surface area heuristic ratios
+    */
+    double get_area() const
+    {
+        double xlen = x_max - x_min, ylen = y_max - y_min, zlen = z_max - z_min;
+        return xlen * ylen + ylen * zlen + zlen * xlen;
+    }
+
+    double get_min(int axis) const { return (axis == 0) ? x_min : (axis == 1) ? y_min : z_min; }
+    double get_max(int axis) const { return (axis == 0) ? x_max : (axis == 1) ? y_max : z_max; }
+
     double get_meanx() const { return (x_max + x_min)/2; }
     double get_meany() const { return (y_max + y_min)/2; }
     double get_meanz() const { return (z_max + z_min)/2; }
@@ -95,182 +177,1737 @@ struct max_min_crds_t
 };
 
 
-namespace detail {
+/**
+ * \brief reorders vec in place so that vec[i] becomes old vec[order[i]], following permutation cycles
+ *        so only one extra element is stored. order is turned into identity.
+*/
+template <typename T>
+void apply_permutation(std::vector<T> &vec, std::vector<index_t> &order)
+{
+    for (index_t i = 0, num = static_cast<index_t>(order.size()); i < num; ++i)
+    {
+        if (order[i] == i) continue;
+
+        T tmp = std::move(vec[i]);
+        index_t j = i;
+
+        for (;;)
+        {
+            index_t next = order[j];
+            order[j] = j;
+
+            if (next == i) { vec[j] = std::move(tmp); break; }
+
+            vec[j] = std::move(vec[next]);
+            j = next;
+        }
+    }
+}
 
-class node_t
+/**
+ * \brief copies the root of subtree into nodes[idx] and the rest of it to the end of nodes with shifted child offsets
+*/
+template <typename node_type>
+void append_subtree(std::vector<node_type> &nodes, index_t idx, const std::vector<node_type> &subtree)
 {
-    bool isleaf_ = true;
-    node_t* parent_ = nullptr;
+    index_t shift = static_cast<index_t>(nodes.size()) - 1;
 
-    node_position pos_;
+    auto shifted = [shift] (node_type node) {
+        if (!node.is_leaf()) node.child_ += shift;
+        return node;
+    };
+
+    nodes[idx] = shifted(subtree[0]);
+
+    for (size_t i = 1, num = subtree.size(); i < num; ++i)
+        nodes.push_back(shifted(subtree[i]));
+}
+
+/* ids of two intersecting triags, first < second */
+using id_pair_t   = std::pair<index_t, index_t>;
+using pair_vector = std::vector<id_pair_t>;
+
+/**
+ * \brief flag mode of the narrow phase: marks both triags if they intersect,
+ *        the test is skipped when both are already marked
+*/
+inline void test_pair(const triag_id_t &it, const triag_id_t &jt, std::vector<bool> &answer)
+{
+    if (answer[it.id] && answer[jt.id]) return;
+
+    if (it.triag.intersects(jt.triag)) {
+        answer[it.id] = true;
+        answer[jt.id] = true;
+    }
+}
+
+/**
+ * \brief pair mode of the narrow phase: every intersecting pair is appended
+*/
+inline void test_pair(const triag_id_t &it, const triag_id_t &jt, pair_vector &pairs)
+{
+    if (!it.triag.intersects(jt.triag)) return;
+
+    index_t a = static_cast<index_t>(it.id), b = static_cast<index_t>(jt.id);
+    pairs.emplace_back(std::min(a, b), std::max(a, b));
+}
+
+/**
+ * \brief sorts pairs and removes the repeated ones, engines may report a pair more than once
+*/
+inline void sort_pairs(pair_vector &pairs)
+{
+    std::sort(pairs.begin(), pairs.end());
+    pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+}
 
-    std::array<plane_t, 3> planes_ = {plane_t{{1, 0, 0}, {pos_.x_, 0, 0}},
-                                      plane_t{{0, 1, 0}, {0, pos_.y_, 0}},
-                                      plane_t{{0, 0, 1}, {0, 0, pos_.z_}}};
+/**
+ * \brief own copy of the answer for every worker of a parallel query
+*/
+inline std::vector<std::vector<bool>> make_answers(const std::vector<bool> &answer, size_t worker_num)
+{
+    return std::vector<std::vector<bool>>(worker_num, std::vector<bool>(answer.size(), false));
+}
+
+inline std::vector<pair_vector> make_answers(const pair_vector &, size_t worker_num)
+{
+    return std::vector<pair_vector>(worker_num);
+}
 
-    std::array<node_t*, child_num> children_;
-    std::array<triag_vector, child_num+1> triangle_vectors_;
+inline void merge_answers(const std::vector<std::vector<bool>> &answers, std::vector<bool> &answer)
+{
+    for (auto &worker_answer : answers)
+        for (size_t i = 0, num = answer.size(); i < num; ++i)
+            if (worker_answer[i]) answer[i] = true;
+}
 
+inline void merge_answers(const std::vector<pair_vector> &answers, pair_vector &pairs)
+{
+    for (auto &worker_pairs : answers)
+        pairs.insert(pairs.end(), worker_pairs.begin(), worker_pairs.end());
 
-public:
-    size_t       triag_num_ = 0;
-    triag_vector triags_;
+    sort_pairs(pairs);
+}
 
 /*==========================================================================*/
 
-    node_t(node_t* parent, node_position pos, triag_vector triags, std::list<node_t> &nodes) : parent_(parent), pos_(pos), triags_(triags)
+const int triag_type_num = 3;
+
+/**
+ * \brief what the narrow phase did with the candidate pairs of a query
+*/
+struct pair_stats_t
+{
+    size_t candidates      = 0; // pairs given to the narrow phase by the broad phase
+    size_t skipped         = 0; // both triags were already marked
+    size_t sphere_rejected = 0; // rejected by triangle_t::spheres_overlap()
+    size_t intersecting    = 0;
+
+    /* exact tests by the types of both triags, dispatch[TRIAG][SEGMENT] and dispatch[SEGMENT][TRIAG] are different calls */
+    std::array<std::array<size_t, triag_type_num>, triag_type_num> dispatch{};
+
+    void merge(const pair_stats_t &other)
     {
-        triag_num_ = triags.size();
+        candidates      += other.candidates;
+        skipped         += other.skipped;
+        sphere_rejected += other.sphere_rejected;
+        intersecting    += other.intersecting;
 
-        if (triag_num_ < SIZE_OF_PART){ /* print(); */ return; }
+        for (int i = 0; i < triag_type_num; ++i)
+            for (int j = 0; j < triag_type_num; ++j) dispatch[i][j] += other.dispatch[i][j];
+    }
+};
 
-        isleaf_ = false;
+/**
+ * \brief flag mode answer that also counts pair_stats_t, used only for diagnostics since counting slows the query down
+*/
+struct stats_answer_t
+{
+    std::vector<bool> flags;
+    pair_stats_t      stats;
+};
 
-        isleaf_ = false;
+inline void test_pair(const triag_id_t &it, const triag_id_t &jt, stats_answer_t &answer)
+{
+    pair_stats_t &stats = answer.stats;
+    ++stats.candidates;
 
-        double next_rad = pos_.rad_ / 2;
+    if (answer.flags[it.id] && answer.flags[jt.id]) { ++stats.skipped; return; }
 
-        std::vector<node_position> children_pos;
+    if (!it.triag.spheres_overlap(jt.triag)) { ++stats.sphere_rejected; return; }
 
-        for (int i = 0; i < child_num; ++i)
-            children_pos.push_back({pos_.x_ + ((i & (1 << 0)) ? -next_rad : next_rad),
-                                    pos_.y_ + ((i & (1 << 1)) ? -next_rad : next_rad),
-                                    pos_.z_ + ((i & (1 << 2)) ? -next_rad : next_rad),
-                                    next_rad});
+    ++stats.dispatch[it.triag.get_type()][jt.triag.get_type()];
 
-        for (auto it = triags_.begin(), ite = triags_.end(); it != ite; ++it) triag_emplace(*it);
+    if (it.triag.intersects(jt.triag)) {
+        answer.flags[it.id] = true;
+        answer.flags[jt.id] = true;
+        ++stats.intersecting;
+    }
+}
 
-        //print();
+inline std::vector<stats_answer_t> make_answers(const stats_answer_t &answer, size_t worker_num)
+{
+    return std::vector<stats_answer_t>(worker_num, stats_answer_t{std::vector<bool>(answer.flags.size(), false), {}});
+}
 
-        for (int i = 0; i < child_num; ++i)
-        {
-            nodes.push_back(node_t{this, children_pos[i], triangle_vectors_[i], nodes});
-            children_[i] = &(*std::prev(nodes.end()));
-        }
+inline void merge_answers(const std::vector<stats_answer_t> &answers, stats_answer_t &answer)
+{
+    for (auto &worker_answer : answers)
+    {
+        for (size_t i = 0, num = answer.flags.size(); i < num; ++i)
+            if (worker_answer.flags[i]) answer.flags[i] = true;
+
+        answer.stats.merge(worker_answer.stats);
     }
+}
 
-/*==========================================================================*/
+/**
+ * \brief flag mode answer whose narrow phase is triangle_t::intersects_exact() instead of the tolerant intersects()
+*/
+struct exact_answer_t
+{
+    std::vector<bool> flags;
+};
+
+inline void test_pair(const triag_id_t &it, const triag_id_t &jt, exact_answer_t &answer)
+{
+    if (answer.flags[it.id] && answer.flags[jt.id]) return;
+
+    if (it.triag.intersects_exact(jt.triag)) {
+        answer.flags[it.id] = true;
+        answer.flags[jt.id] = true;
+    }
+}
+
+inline std::vector<exact_answer_t> make_answers(const exact_answer_t &answer, size_t worker_num)
+{
+    return std::vector<exact_answer_t>(worker_num, exact_answer_t{std::vector<bool>(answer.flags.size(), false)});
+}
+
+inline void merge_answers(const std::vector<exact_answer_t> &answers, exact_answer_t &answer)
+{
+    for (auto &worker_answer : answers)
+        for (size_t i = 0, num = answer.flags.size(); i < num; ++i)
+            if (worker_answer.flags[i]) answer.flags[i] = true;
+}
+
+/**
+ * \brief shape of a built octree, vectors are indexed by depth except leaf_occupancy:
+ *        leaf_occupancy[0] counts empty leaves, leaf_occupancy[k] leaves with [2^(k-1), 2^k) triags
+*/
+struct tree_stats_t
+{
+    size_t node_num = 0;
+    size_t leaf_num = 0;
+    size_t max_leaf = 0;
+
+    std::vector<size_t> depth_nodes;   // nodes at every depth
+    std::vector<size_t> depth_borders; // triags in the border lists at every depth
+    std::vector<size_t> leaf_occupancy;
+};
+
+
+namespace detail {
+
+/**
+ * \brief read-only array that does not own its elements
+*/
+template <typename T>
+class view_t
+{
+    const T *data_ = nullptr;
+    size_t   size_ = 0;
+
+    public:
+
+    view_t() = default;
+    view_t(const T *data, size_t size) : data_(data), size_(size) {}
+    view_t(const std::vector<T> &vec) : data_(vec.data()), size_(vec.size()) {}
+
+    const T& operator[](size_t i) const { return data_[i]; }
+
+    size_t size() const { return size_; }
+    bool  empty() const { return size_ == 0; }
+
+    const T* begin() const { return data_; }
+    const T* end()   const { return data_ + size_; }
+};
+
+/**
+ * \brief node of the flat octree. Triags of the subtree are all_triags_[first_, last_):
+ *        border triags [first_, border_) go first, then the ranges of the children in order.
+ *        Children are child_num consecutive nodes starting from child_, child_ == 0 for a leaf.
+*/
+template <typename real_t>
+struct basic_node_t
+{
+    basic_node_position<real_t> pos_{0, 0, 0, 0};
+
+    index_t first_  = 0;
+    index_t border_ = 0;
+    index_t last_   = 0;
+    index_t child_  = 0;
+
+    bool is_leaf() const { return child_ == 0; }
+
+    index_t triag_num() const { return last_ - first_; }
+
+    basic_node_position<real_t> child_pos(int i) const { return pos_.child_pos(i); }
 
     void print() const
     {
-        std::cout << "isleaf = " << isleaf_ << std::endl;
-        std::cout << "parent = " << parent_ << " this = " << this << std::endl;
-        std::cout << "number of elements = " << triag_num_ << std::endl;
-        std::cout << "numer of triags in border = " << triangle_vectors_[child_num].size() << std::endl;
+        std::cout << "isleaf = " << is_leaf() << std::endl;
+        std::cout << "number of elements = " << triag_num() << std::endl;
+        std::cout << "numer of triags in border = " << border_ - first_ << std::endl;
 
         std::cout << "\n\n";
     }
+};
+
+using node_t = basic_node_t<double>;
+
+/*==========================================================================*/
 
+/**
+ * \brief with loose_factor > 1 a child cube is enlarged loose_factor times around its center,
+ *        a triag goes to the child that holds its centroid if it fits into the enlarged cube
+*/
+class node_classifier_t
+{
+    node_position pos_;
+    double        loose_factor_;
 
-    void triag_emplace(triag_id_t triag)
+    cube_positions check_loose(const triangle_t &triag) const
     {
-        cube_positions triag_pos = check_triangle(triag);
+        max_min_crds_t box{};
+        box.update(triag);
+
+        point_t A{triag.getA()}, B{triag.getB()}, C{triag.getC()};
+
+        int ret = 0;
+        if (A.get_x() + B.get_x() + C.get_x() < 3 * pos_.x_) ret |= (1 << 0);
+        if (A.get_y() + B.get_y() + C.get_y() < 3 * pos_.y_) ret |= (1 << 1);
+        if (A.get_z() + B.get_z() + C.get_z() < 3 * pos_.z_) ret |= (1 << 2);
+
+        double next_rad  = pos_.rad_ / 2;
+        double loose_rad = loose_factor_ * next_rad;
+
+        double x = pos_.x_ + ((ret & (1 << 0)) ? -next_rad : next_rad);
+        double y = pos_.y_ + ((ret & (1 << 1)) ? -next_rad : next_rad);
+        double z = pos_.z_ + ((ret & (1 << 2)) ? -next_rad : next_rad);
 
-        triangle_vectors_[triag_pos].push_back(triag);
+        bool fits = box.x_min >= x - loose_rad && box.x_max <= x + loose_rad &&
+                    box.y_min >= y - loose_rad && box.y_max <= y + loose_rad &&
+                    box.z_min >= z - loose_rad && box.z_max <= z + loose_rad;
+
+        return fits ? static_cast<cube_positions>(ret) : BORDER;
     }
 
-/*==========================================================================*/
+    public:
 
-    cube_positions check_triangle(triag_id_t triag) const
+    node_classifier_t(const node_position &pos, double loose_factor = 1) : pos_(pos), loose_factor_(loose_factor) {}
+
+    /**
+     * \brief child of a tight tree that holds the box. The splitting planes are axis aligned, so instead of the sides
+     *        of every vertex only the box sides are compared: the box is in the positive half-space along an axis
+     *        if its min is at least ACCURACY past the center, in the negative one if its max is, on the border otherwise
+    */
+    cube_positions check_box(const max_min_crds_t &box) const
     {
-        std::array<std::array<double, 3>, 3> res;
+        const double center[3] = {pos_.x_, pos_.y_, pos_.z_};
 
-        for (int i = 0; i < 3; i++)
+        int ret = 0;
+        for (int axis = 0; axis < 3; ++axis)
         {
-            res[i][0] = planes_[i].calc_point(triag.triag.getA());
-            res[i][1] = planes_[i].calc_point(triag.triag.getB());
-            res[i][2] = planes_[i].calc_point(triag.triag.getC());
-        }
+            if (box.get_min(axis) - center[axis] >= ACCURACY) continue;
+            if (box.get_max(axis) - center[axis] <= -ACCURACY) { ret |= (1 << axis); continue; }
 
-        std::array<bool, 3> pos_neg_positions;
-        for (int i = 0; i < 3; ++i)
-        {
-            if (all_positive(res[i][0], res[i][1], res[i][2]))
-                pos_neg_positions[i] = true;
+            return BORDER;
+        }
 
-            else if (all_negative(res[i][0], res[i][1], res[i][2]))
-                pos_neg_positions[i] = false;
+        return static_cast<cube_positions>(ret);
+    }
 
-            else return BORDER;
-        }
+    cube_positions check_triangle(const triangle_t &triag) const
+    {
+        if (is_loose()) return check_loose(triag);
 
-        int ret = 0;
-        for (int i = 0; i < 3; ++i)
-            if (!pos_neg_positions[i]) ret |= (1 << i);
+        max_min_crds_t box{};
+        box.update(triag);
 
-        return static_cast<cube_positions>(ret);
+        return check_box(box);
     }
 
+    std::array<double, 3> get_center() const { return {pos_.x_, pos_.y_, pos_.z_}; }
+
+    bool is_loose() const { return loose_factor_ > 1; }
+};
+
+}
+
+
 /*==========================================================================*/
 
-    void get_collisions(std::vector<bool> &answer)
+/**
+ * \brief ball for octree_t::query()
+*/
+struct sphere_t
+{
+    point_t center;
+    double  rad;
+};
+
+enum ray_mode
+{
+    CLOSEST_HIT, // the nearest hit only
+    ANY_HIT,     // some hit, the traversal stops at the first one found
+    ALL_HITS     // every hit sorted by distance
+};
+
+struct ray_hit_t
+{
+    size_t id;
+    double dist; // the hit point is ray.get_point(dist)
+};
+
+
+namespace detail {
+
+using crds_t = std::array<double, 3>;
+
+inline double dot(const crds_t &a, const crds_t &b) { return a[0] * b[0] + a[1] * b[1] + a[2] * b[2]; }
+
+inline crds_t cross(const crds_t &a, const crds_t &b)
+{
+    return {a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0]};
+}
+
+inline crds_t sub(const crds_t &a, const crds_t &b) { return {a[0] - b[0], a[1] - b[1], a[2] - b[2]}; }
+
+inline crds_t get_crds(const point_t &pnt) { return {pnt.get_x(), pnt.get_y(), pnt.get_z()}; }
+
+/**
+ * \brief separating axis test of a triag and a box, the 13 axes are the box normals, the triag normal
+ *        and the products of the triag edges with the box normals. Zero axes of degenerate triags never separate,
+ *        so segments and points are handled by the same code. Gaps up to eps count as overlap.
+*/
+inline bool triag_box_overlap(const triangle_t &triag, const max_min_crds_t &box, double eps)
+{
+    crds_t center{box.get_meanx(), box.get_meany(), box.get_meanz()};
+    crds_t half;
+    for (int axis = 0; axis < 3; ++axis) half[axis] = (box.get_max(axis) - box.get_min(axis)) / 2 + eps;
+
+    std::array<crds_t, 3> vert{sub(get_crds(triag.getA()), center),
+                               sub(get_crds(triag.getB()), center),
+                               sub(get_crds(triag.getC()), center)};
+
+    auto separates = [&vert, &half] (const crds_t &axis) {
+        double p0 = dot(vert[0], axis), p1 = dot(vert[1], axis), p2 = dot(vert[2], axis);
+        double r  = half[0] * std::abs(axis[0]) + half[1] * std::abs(axis[1]) + half[2] * std::abs(axis[2]);
+
+        return triple_min(p0, p1, p2) > r || triple_max(p0, p1, p2) < -r;
+    };
+
+    for (int axis = 0; axis < 3; ++axis)
     {
-        if (isleaf_)
+        crds_t normal{};
+        normal[axis] = 1;
+
+        if (separates(normal)) return false;
+    }
+
+    std::array<crds_t, 3> edge{sub(vert[1], vert[0]), sub(vert[2], vert[1]), sub(vert[0], vert[2])};
+
+    if (separates(cross(edge[0], edge[1]))) return false;
+
+    for (int i = 0; i < 3; ++i)
+        for (int axis = 0; axis < 3; ++axis)
         {
-            for (auto it = triags_.begin(), ite = triags_.end(); it != ite; ++it) {
-                for (auto jt = std::next(it), jte = triags_.end(); jt != jte; ++jt) {
+            crds_t normal{};
+            normal[axis] = 1;
 
-                    if (it->triag.intersects(jt->triag)) {
-                        answer[it->id] = true;
-                        answer[jt->id] = true;
-                    }
-                }
-            } return;
+            if (separates(cross(edge[i], normal))) return false;
         }
 
-        for (int i = 0; i < child_num; i++)
-            children_[i]->get_collisions(answer);
+    return true;
+}
+
+inline double sq_dist_to_segment(const crds_t &pnt, const crds_t &a, const crds_t &b)
+{
+    crds_t ab = sub(b, a), ap = sub(pnt, a);
 
-        for (auto it = triangle_vectors_[child_num].begin(), ite = triangle_vectors_[child_num].end(); it != ite; ++it) {
-            for (auto jt = triags_.begin(), jte = triags_.end(); jt != jte; ++jt) {
-                if (it->id == jt->id) continue;
+    double len = dot(ab, ab);
+    double t   = (len > 0) ? std::min(std::max(dot(ap, ab) / len, 0.0), 1.0) : 0;
 
-                if (it->triag.intersects(jt->triag)) {
-                    answer[it->id] = true;
-                    answer[jt->id] = true;
-                }
-            }
+    crds_t diff{ap[0] - t * ab[0], ap[1] - t * ab[1], ap[2] - t * ab[2]};
+    return dot(diff, diff);
+}
+
+/**
+ * \brief the closest point of a triag is either on its edges or the projection of the center when it falls inside
+*/
+inline bool triag_sphere_overlap(const triangle_t &triag, const sphere_t &sphere, double eps)
+{
+    crds_t pnt = get_crds(sphere.center);
+    crds_t a = get_crds(triag.getA()), b = get_crds(triag.getB()), c = get_crds(triag.getC());
+
+    double dist = triple_min(sq_dist_to_segment(pnt, a, b), sq_dist_to_segment(pnt, b, c), sq_dist_to_segment(pnt, c, a));
+
+    crds_t normal = cross(sub(b, a), sub(c, a));
+    double n_len  = dot(normal, normal);
+
+    if (triag.get_type() == TRIAG && n_len > 0 &&
+        dot(cross(sub(b, a), sub(pnt, a)), normal) >= 0 &&
+        dot(cross(sub(c, b), sub(pnt, b)), normal) >= 0 &&
+        dot(cross(sub(a, c), sub(pnt, c)), normal) >= 0)
+    {
+        double height = dot(sub(pnt, a), normal);
+        dist = std::min(dist, height * height / n_len);
+    }
+
+    double rad = sphere.rad + eps;
+    return dist <= rad * rad;
+}
+
+/**
+ * \brief slab test, returns t where the ray enters the box enlarged by eps or NAN if it misses the box before max_dist
+*/
+inline double ray_box_entry(const crds_t &origin, const crds_t &dir, const max_min_crds_t &box, double max_dist, double eps)
+{
+    if (!(box.x_min <= box.x_max)) return NAN;
+
+    double t_min = 0, t_max = max_dist;
+
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        double lo = box.get_min(axis) - eps, hi = box.get_max(axis) + eps;
+
+        if (dir[axis] == 0)
+        {
+            if (origin[axis] < lo || origin[axis] > hi) return NAN;
+            continue;
         }
+
+        double t1 = (lo - origin[axis]) / dir[axis];
+        double t2 = (hi - origin[axis]) / dir[axis];
+        if (t1 > t2) std::swap(t1, t2);
+
+        t_min = std::max(t_min, t1);
+        t_max = std::min(t_max, t2);
+
+        if (t_min > t_max) return NAN;
     }
+
+    return t_min;
+}
+
+/* bounding box and exact test of every shape that octree_t::query() takes */
+
+inline max_min_crds_t get_box(const triangle_t &triag)
+{
+    max_min_crds_t box{};
+    box.update(triag);
+
+    return box;
+}
+
+inline max_min_crds_t get_box(const max_min_crds_t &box) { return box; }
+
+inline max_min_crds_t get_box(const sphere_t &sphere)
+{
+    max_min_crds_t box{};
+    box.update(sphere.center.get_x() - sphere.rad, sphere.center.get_y() - sphere.rad, sphere.center.get_z() - sphere.rad);
+    box.update(sphere.center.get_x() + sphere.rad, sphere.center.get_y() + sphere.rad, sphere.center.get_z() + sphere.rad);
+
+    return box;
+}
+
+inline bool hits(const triangle_t &triag, const triangle_t &shape) { return triag.intersects(shape); }
+
+inline bool hits(const triangle_t &triag, const max_min_crds_t &box) { return triag_box_overlap(triag, box, ACCURACY); }
+
+inline bool hits(const triangle_t &triag, const sphere_t &sphere) { return triag_sphere_overlap(triag, sphere, ACCURACY); }
+
+}
+
+
+struct octree_params_t
+{
+    size_t   thread_num   = 1;
+    double   loose_factor = 1;
+    size_t   leaf_size    = SIZE_OF_PART; // nodes with fewer triags are leaves, AUTO_LEAF_SIZE to choose it by sampling
+    unsigned max_depth    = MAX_DEPTH;
+    bool     float_filter = false;        // run the batched filter on a float block, see kernels::precision_t<float>
+};
+
+
+namespace detail {
+
+/**
+ * \brief start of the octree index file. Arrays of triag_id_t, node_t and max_min_crds_t are stored as they are in memory,
+ *        so the sizes and the byte order written here have to match the reading build. The compact blocks follow them:
+ *        block_field arrays of triag_num values, every array starts at a multiple of INDEX_ALIGN
+*/
+struct index_header_t
+{
+    char     magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t triag_size;
+    uint32_t node_size;
+    uint64_t triag_num;
+    uint64_t node_num;
+    uint64_t box_num;
+    uint64_t leaf_size;
+    uint32_t max_depth;
+    uint32_t reserved;
+    double   loose_factor;
+    uint64_t triags_offset;
+    uint64_t nodes_offset;
+    uint64_t boxes_offset;
+    uint64_t block_offset;
+    uint64_t float_block_offset; // 0 if the coordinates do not fit a float block
+    double   block_scale;
+    double   block_crd_scale;
 };
 
+const char     INDEX_MAGIC[8]   = {'T', 'R', 'I', 'O', 'C', 'T', 'R', 'E'};
+const uint32_t INDEX_BYTE_ORDER = 0x01020304;
+
 }
 
 
 class octree_t
 {
-    detail::node_t* root_ = nullptr;
-    std::list<detail::node_t> nodes_;
+    /* storage of a built tree, empty when the tree is mapped from an index file */
+    triag_vector                own_triags_;
+    std::vector<detail::node_t> own_nodes_;
+    std::vector<max_min_crds_t> own_boxes_;
+
+    /* queries read the tree only through these views, they point to the storage above or into file_ */
+    detail::view_t<triag_id_t>     all_triags_;
+    detail::view_t<detail::node_t> nodes_;
+    detail::view_t<max_min_crds_t> boxes_;
+
+    std::shared_ptr<const files::mapped_file_t> file_;
+
+    /* compact form of all_triags_ that the hot loops read, rebuilt when a tree is mapped.
+       Only one of them is built, float_block_ when float_filter_ is set and the coordinates fit it */
+    kernels::triag_block_t      block_;
+    kernels::float_block_t      float_block_;
+    bool                        float_filter_ = false;
+
+    /* permutation of own_triags_ used only while building, own_triags_ is reordered by it at the end */
+    std::vector<index_t>        order_;
+
+    /* bounding boxes of own_triags_ in their original order, used only while building a tight tree */
+    std::array<std::vector<double>, 3> build_lo_, build_hi_;
+
+    /* children of a loose tree overlap, so triags of different children are tested when tight boxes of the subtrees overlap */
+    double                      loose_factor_ = 1;
+
+    size_t                      leaf_size_ = SIZE_OF_PART;
+    unsigned                    max_depth_ = MAX_DEPTH;
+
+    using bounds_t = std::array<index_t, child_num+2>;
+
+    static_assert(std::is_trivially_copyable<triag_id_t>::value && std::is_trivially_copyable<detail::node_t>::value &&
+                  std::is_trivially_copyable<max_min_crds_t>::value, "index file stores these types as raw bytes");
+
+    octree_t() = default;
 
-    triag_vector all_triags_;
+/*==========================================================================*/
 
-public:
-    std::set<triag_id_t> border_triags_;
+    public:
 
+    octree_t(triag_vector all_triags, size_t thread_num = 1, double loose_factor = 1) :
+    octree_t(std::move(all_triags), octree_params_t{thread_num, loose_factor}) {}
 
-    octree_t(triag_vector all_triags) : all_triags_(all_triags)
+    octree_t(triag_vector all_triags, const octree_params_t &params) :
+    own_triags_(std::move(all_triags)), float_filter_(params.float_filter), loose_factor_(std::max(params.loose_factor, 1.0)),
+    leaf_size_(params.leaf_size), max_depth_(params.max_depth)
     {
-        max_min_crds_t min_max{};
+        if (leaf_size_ == AUTO_LEAF_SIZE) leaf_size_ = tune_leaf_size(params);
+
+        index_t triag_num = static_cast<index_t>(own_triags_.size());
+
+        order_.resize(triag_num);
+        for (index_t i = 0; i < triag_num; ++i) order_[i] = i;
 
-        for (auto it = all_triags_.begin(); it != all_triags_.end(); it++)
+        detail::node_t root{};
+        root.last_ = triag_num;
+
+        own_nodes_.push_back(root);
+
+        if (params.thread_num > 1)
         {
-            point_t A{it->triag.getA()};
-            point_t B{it->triag.getB()};
-            point_t C{it->triag.getC()};
+            tasks::task_pool_t pool{params.thread_num};
 
-            min_max.update(A.get_x(), A.get_y(), A.get_z());
-            min_max.update(B.get_x(), B.get_y(), B.get_z());
-            min_max.update(C.get_x(), C.get_y(), C.get_z());
+            own_nodes_[0].pos_ = get_root_pos(&pool);
+            if (!is_loose()) calc_build_boxes(&pool);
+            split_parallel(own_nodes_, 0, 0, pool);
+        }
+        else
+        {
+            own_nodes_[0].pos_ = get_root_pos(nullptr);
+            if (!is_loose()) calc_build_boxes(nullptr);
+            split(own_nodes_, 0, 0);
         }
 
-        node_position pos{min_max.get_meanx(), min_max.get_meany(), min_max.get_meanz(), min_max.get_rad()};
+        apply_order();
 
-        nodes_.push_back(detail::node_t{nullptr, pos, all_triags_, nodes_});
-        root_ = &(*std::prev(nodes_.end()));
+        if (is_loose()) calc_boxes();
+
+        all_triags_ = own_triags_;
+        nodes_      = own_nodes_;
+        boxes_      = own_boxes_;
+
+        build_block();
     }
 
-    void print() const { root_->print(); }
-    void get_collisions(std::vector<bool> &answer) { root_->get_collisions(answer); }
+    /* views point into the storage, moving a vector keeps its buffer but copying does not */
+    octree_t(const octree_t&) = delete;
+    octree_t& operator=(const octree_t&) = delete;
+
+    octree_t(octree_t&&) = default;
+    octree_t& operator=(octree_t&&) = default;
+
+    /**
+     * \brief writes the tree to an index file that open_index() maps back without rebuilding
+    */
+    void save_index(const std::string &path) const
+    {
+        /* both blocks are written whatever this tree filters with, so the file can be opened either way */
+        kernels::triag_block_t own_block;
+        kernels::float_block_t own_float_block;
+
+        const kernels::triag_block_t &block       = (block_.size() == all_triags_.size()) ? block_ : fill_block(own_block);
+        const kernels::float_block_t &float_block = float_filter_ ? float_block_ : fill_block(own_float_block);
+
+        detail::index_header_t header{};
+
+        std::memcpy(header.magic, detail::INDEX_MAGIC, sizeof(header.magic));
+        header.version         = INDEX_VERSION;
+        header.byte_order      = detail::INDEX_BYTE_ORDER;
+        header.triag_size      = sizeof(triag_id_t);
+        header.node_size       = sizeof(detail::node_t);
+        header.triag_num       = all_triags_.size();
+        header.node_num        = nodes_.size();
+        header.box_num         = boxes_.size();
+        header.leaf_size       = leaf_size_;
+        header.max_depth       = max_depth_;
+        header.loose_factor    = loose_factor_;
+        header.block_scale     = block.scale();
+        header.block_crd_scale = block.crd_scale();
+
+        auto align = [] (uint64_t offset) { return (offset + INDEX_ALIGN - 1) / INDEX_ALIGN * INDEX_ALIGN; };
+
+        header.triags_offset = align(sizeof(header));
+        header.nodes_offset  = align(header.triags_offset + header.triag_num * sizeof(triag_id_t));
+        header.boxes_offset  = align(header.nodes_offset  + header.node_num  * sizeof(detail::node_t));
+        header.block_offset  = align(header.boxes_offset  + header.box_num   * sizeof(max_min_crds_t));
+
+        uint64_t field_size = align(header.triag_num * sizeof(double));
+        if (float_block.fits()) header.float_block_offset = header.block_offset + kernels::FIELD_NUM * field_size;
+
+        std::ofstream out{path, std::ios::binary};
+        if (!out) throw std::runtime_error{"can't create " + path};
+
+        auto write_at = [&out] (uint64_t offset, const void *data, size_t size) {
+            static const char zeros[INDEX_ALIGN] = {};
+
+            for (uint64_t pos = static_cast<uint64_t>(out.tellp()); pos < offset; pos += INDEX_ALIGN)
+                out.write(zeros, static_cast<std::streamsize>(std::min<uint64_t>(INDEX_ALIGN, offset - pos)));
+
+            out.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+        };
+
+        write_at(0, &header, sizeof(header));
+        write_at(header.triags_offset, all_triags_.begin(), header.triag_num * sizeof(triag_id_t));
+        write_at(header.nodes_offset,  nodes_.begin(),      header.node_num  * sizeof(detail::node_t));
+        write_at(header.boxes_offset,  boxes_.begin(),      header.box_num   * sizeof(max_min_crds_t));
+
+        for (int f = 0; f < kernels::FIELD_NUM; ++f)
+            write_at(header.block_offset + f * field_size, block.data(f), header.triag_num * sizeof(double));
+
+        if (header.float_block_offset)
+        {
+            uint64_t float_field_size = align(header.triag_num * sizeof(float));
+
+            for (int f = 0; f < kernels::FIELD_NUM; ++f)
+                write_at(header.float_block_offset + f * float_field_size, float_block.data(f), header.triag_num * sizeof(float));
+        }
+
+        if (!out) throw std::runtime_error{"can't write " + path};
+    }
+
+    /**
+     * \brief maps an index file written by save_index(), the file has to be written by a build with the same layout.
+     *        Every node is checked before the tree is returned, so a corrupt file is rejected instead of read out of bounds
+    */
+    static octree_t open_index(const std::string &path, bool float_filter = false)
+    {
+        auto file = std::make_shared<const files::mapped_file_t>(path);
+
+        detail::index_header_t header;
+        if (file->size() < sizeof(header)) throw std::runtime_error{path + " is not an octree index"};
+
+        std::memcpy(&header, file->data(), sizeof(header));
+
+        if (std::memcmp(header.magic, detail::INDEX_MAGIC, sizeof(header.magic)))
+            throw std::runtime_error{path + " is not an octree index"};
+
+        if (header.version != INDEX_VERSION || header.byte_order != detail::INDEX_BYTE_ORDER ||
+            header.triag_size != sizeof(triag_id_t) || header.node_size != sizeof(detail::node_t))
+            throw std::runtime_error{path + " is written by an incompatible version"};
+
+        /* num elements of size bytes at offset are in the file, the products can't overflow */
+        auto in_file = [&file] (uint64_t offset, uint64_t num, uint64_t size) {
+            return offset % INDEX_ALIGN == 0 && offset <= file->size() && num <= (file->size() - offset) / size;
+        };
+
+        uint64_t field_size       = (header.triag_num * sizeof(double) + INDEX_ALIGN - 1) / INDEX_ALIGN * INDEX_ALIGN;
+        uint64_t float_field_size = (header.triag_num * sizeof(float)  + INDEX_ALIGN - 1) / INDEX_ALIGN * INDEX_ALIGN;
+
+        if (header.triag_num > std::numeric_limits<index_t>::max() || header.node_num == 0 ||
+            !in_file(header.triags_offset, header.triag_num, sizeof(triag_id_t)) ||
+            !in_file(header.nodes_offset,  header.node_num,  sizeof(detail::node_t)) ||
+            !in_file(header.boxes_offset,  header.box_num,   sizeof(max_min_crds_t)) ||
+            !in_file(header.block_offset, (kernels::FIELD_NUM - 1) * field_size + header.triag_num * sizeof(double), 1) ||
+            (header.float_block_offset &&
+             !in_file(header.float_block_offset, (kernels::FIELD_NUM - 1) * float_field_size + header.triag_num * sizeof(float), 1)))
+            throw std::runtime_error{path + " is truncated"};
+
+        octree_t tree;
+
+        tree.all_triags_ = {reinterpret_cast<const triag_id_t*>(file->data() + header.triags_offset), header.triag_num};
+        tree.nodes_      = {reinterpret_cast<const detail::node_t*>(file->data() + header.nodes_offset), header.node_num};
+        tree.boxes_      = {reinterpret_cast<const max_min_crds_t*>(file->data() + header.boxes_offset), header.box_num};
+
+        tree.loose_factor_ = header.loose_factor;
+        tree.leaf_size_    = header.leaf_size;
+        tree.max_depth_    = header.max_depth;
+
+        if (!tree.is_valid()) throw std::runtime_error{path + " is corrupt"};
+
+        std::array<const double*, kernels::FIELD_NUM> fields;
+        for (int f = 0; f < kernels::FIELD_NUM; ++f)
+            fields[f] = reinterpret_cast<const double*>(file->data() + header.block_offset + f * field_size);
+
+        tree.block_ = kernels::triag_block_t{fields, header.triag_num, header.block_scale, header.block_crd_scale};
+
+        if (float_filter && header.float_block_offset)
+        {
+            std::array<const float*, kernels::FIELD_NUM> float_fields;
+            for (int f = 0; f < kernels::FIELD_NUM; ++f)
+                float_fields[f] = reinterpret_cast<const float*>(file->data() + header.float_block_offset + f * float_field_size);
+
+            tree.float_block_  = kernels::float_block_t{float_fields, header.triag_num, header.block_scale, header.block_crd_scale};
+            tree.float_filter_ = true;
+        }
+
+        tree.file_ = std::move(file);
+
+        return tree;
+    }
+
+    void print() const { nodes_[0].print(); }
+
+    size_t node_num() const { return nodes_.size(); }
+
+    bool is_loose() const { return loose_factor_ > 1; }
+
+    /**
+     * \brief the filter runs on the float block, false when float_filter was not asked for or the coordinates do not fit it
+    */
+    bool is_float_filtered() const { return float_filter_; }
+
+    size_t leaf_size() const { return leaf_size_; }
+
+    unsigned max_depth() const { return max_depth_; }
+
+    /**
+     * \brief share of triags that are kept in border lists instead of leaves
+    */
+    double border_fraction() const
+    {
+        if (all_triags_.empty()) return 0;
+
+        size_t border_num = 0;
+        for (auto &node : nodes_) border_num += node.border_ - node.first_;
+
+        return static_cast<double>(border_num) / all_triags_.size();
+    }
+
+    const detail::view_t<triag_id_t>& triags() const { return all_triags_; }
+
+    /**
+     * \brief number of pairs passed to the narrow phase by get_collisions()
+    */
+    size_t pair_test_num() const { return pair_test_num(0); }
+
+    tree_stats_t get_stats() const
+    {
+        tree_stats_t stats;
+        stats.node_num = nodes_.size();
+
+        collect_stats(0, 0, stats);
+
+        return stats;
+    }
+
+    /**
+     * \brief flag mode, answer_t is std::vector<bool> or stats_answer_t
+    */
+    template <typename answer_t>
+    void get_collisions(answer_t &answer) const { get_collisions(0, answer); }
+
+    /**
+     * \brief sorted ids of the stored triags that intersect shape, shape_t is triangle_t, max_min_crds_t or sphere_t.
+     *        Subtrees whose box does not overlap the box of shape are skipped.
+    */
+    template <typename shape_t>
+    std::vector<size_t> query(const shape_t &shape) const
+    {
+        std::vector<size_t> ids;
+        if (nodes_.empty()) return ids;
+
+        query(0, shape, detail::get_box(shape), ids);
+        std::sort(ids.begin(), ids.end());
+
+        return ids;
+    }
+
+    /**
+     * \brief query() for every shape, chunks of QUERY_TASK_SIZE shapes are answered in parallel
+    */
+    template <typename shape_t>
+    std::vector<std::vector<size_t>> query(const std::vector<shape_t> &shapes, size_t thread_num) const
+    {
+        std::vector<std::vector<size_t>> answers(shapes.size());
+
+        run_batch(shapes.size(), thread_num, [this, &shapes, &answers] (size_t i) { answers[i] = query(shapes[i]); });
+
+        return answers;
+    }
+
+    /**
+     * \brief hits of the ray with the stored triags up to max_dist, at most one hit for CLOSEST_HIT and ANY_HIT.
+     *        Children are visited in the order the ray enters their boxes, so a closest hit prunes the farther ones.
+    */
+    std::vector<ray_hit_t> cast_ray(const ray_t &ray, ray_mode mode = CLOSEST_HIT,
+                                    double max_dist = std::numeric_limits<double>::infinity()) const
+    {
+        std::vector<ray_hit_t> hits;
+        if (all_triags_.empty()) return hits;
+
+        detail::crds_t origin = detail::get_crds(ray.get_origin());
+        detail::crds_t dir{ray.get_dir().get_x(), ray.get_dir().get_y(), ray.get_dir().get_z()};
+
+        if (std::isnan(detail::ray_box_entry(origin, dir, node_box(0), max_dist, ACCURACY))) return hits;
+
+        cast_ray(0, ray, origin, dir, mode, max_dist, hits);
+
+        if (mode == ALL_HITS)
+            std::sort(hits.begin(), hits.end(), [] (const ray_hit_t &a, const ray_hit_t &b) {
+                return (a.dist != b.dist) ? a.dist < b.dist : a.id < b.id;
+            });
+
+        return hits;
+    }
+
+    /**
+     * \brief cast_ray() for a packet of rays, chunks of QUERY_TASK_SIZE rays are cast in parallel
+    */
+    std::vector<std::vector<ray_hit_t>> cast_rays(const std::vector<ray_t> &rays, ray_mode mode, size_t thread_num,
+                                                  double max_dist = std::numeric_limits<double>::infinity()) const
+    {
+        std::vector<std::vector<ray_hit_t>> hits(rays.size());
+
+        run_batch(rays.size(), thread_num, [this, &rays, &hits, mode, max_dist] (size_t i) {
+            hits[i] = cast_ray(rays[i], mode, max_dist);
+        });
+
+        return hits;
+    }
+
+    /**
+     * \brief appends every intersecting pair of ids, pairs are sorted and unique
+    */
+    void get_collisions(pair_vector &pairs) const { get_collisions(0, pairs); sort_pairs(pairs); }
+
+    /**
+     * \brief same result as the serial get_collisions(), every worker fills its own copy of answer, copies are merged at the end.
+     *        answer_t is std::vector<bool> or pair_vector
+    */
+    template <typename answer_t>
+    void get_collisions(answer_t &answer, size_t thread_num) const
+    {
+        if (thread_num <= 1) { get_collisions(answer); return; }
+
+        tasks::task_pool_t pool{thread_num};
+        tasks::task_group_t group;
+
+        std::vector<answer_t> answers = make_answers(answer, pool.thread_num());
+
+        pool.spawn(group, [this, &pool, &group, &answers] { get_collisions(0, pool, group, answers); });
+        pool.wait(group);
+
+        merge_answers(answers, answer);
+    }
+
+/*==========================================================================*/
+
+    private:
+
+    template <typename block_t>
+    const block_t& fill_block(block_t &block) const
+    {
+        block.reserve(all_triags_.size());
+        for (auto &triag : all_triags_) block.push_back(triag.triag);
+
+        return block;
+    }
+
+    void build_block()
+    {
+        if (float_filter_)
+        {
+            if (fill_block(float_block_).fits()) return;
+
+            float_block_.clear();
+            float_filter_ = false;
+        }
+
+        fill_block(block_);
+    }
+
+    /**
+     * \brief the nodes read from a file form a tree the queries can walk: children are consecutive nodes after their parent
+     *        and every node is the child of one parent, ranges of the children split the range of the parent below its border
+     *        list, ranges and ids are inside all_triags_, triag types are valid and the tree is not deeper than max_depth_
+    */
+    bool is_valid() const
+    {
+        size_t node_num = nodes_.size(), triag_num = all_triags_.size();
+
+        if (boxes_.size() != (is_loose() ? node_num : 0)) return false;
+
+        /* the type picks the branch of intersects() and the row of the pair stats, it has to be one of triag_type */
+        for (auto &triag : all_triags_)
+            if (triag.id >= triag_num || static_cast<unsigned>(triag.triag.get_type()) > POINT) return false;
+
+        const detail::node_t &root = nodes_[0];
+        if (root.first_ != 0 || root.last_ != triag_num) return false;
+
+        /* children come after their parent, so the depth of every node is known when it is checked */
+        std::vector<unsigned> depth(node_num, 0);
+        std::vector<bool>     reached(node_num, false);
+        reached[0] = true;
+
+        for (size_t idx = 0; idx < node_num; ++idx)
+        {
+            const detail::node_t &node = nodes_[idx];
+
+            if (!reached[idx] || node.first_ > node.border_ || node.border_ > node.last_ || node.last_ > triag_num)
+                return false;
+
+            if (node.is_leaf()) continue;
+
+            /* the sum is taken in 64 bits, so neither it nor a tree of less than child_num nodes wraps */
+            if (node.child_ <= idx || uint64_t{node.child_} + child_num > node_num || depth[idx] >= max_depth_) return false;
+
+            index_t first = node.border_;
+
+            for (int i = 0; i < child_num; ++i)
+            {
+                size_t child = node.child_ + i;
+                if (reached[child] || nodes_[child].first_ != first) return false;
+
+                reached[child] = true;
+                depth[child]   = depth[idx] + 1;
+                first          = nodes_[child].last_;
+            }
+
+            if (first != node.last_) return false;
+        }
+
+        return true;
+    }
+
+    /**
+     * \brief bounding box of all_triags_[i], a float block rounds it outwards
+    */
+    max_min_crds_t triag_box(index_t i) const
+    {
+        auto get_min = [this, i] (int axis) { return float_filter_ ? float_block_.get_min(axis, i) : block_.get_min(axis, i); };
+        auto get_max = [this, i] (int axis) { return float_filter_ ? float_block_.get_max(axis, i) : block_.get_max(axis, i); };
+
+        max_min_crds_t box;
+        box.x_min = get_min(0);  box.x_max = get_max(0);
+        box.y_min = get_min(1);  box.y_max = get_max(1);
+        box.z_min = get_min(2);  box.z_max = get_max(2);
+
+        return box;
+    }
+
+    /**
+     * \brief bounding box of all triags, computed as a parallel reduction over chunks when pool is given
+    */
+    node_position get_root_pos(tasks::task_pool_t *pool) const
+    {
+        size_t triag_num = own_triags_.size();
+        size_t chunk_num = (triag_num + PARALLEL_BUILD_SIZE - 1) / PARALLEL_BUILD_SIZE;
+
+        std::vector<max_min_crds_t> chunk_bounds(chunk_num);
+
+        auto calc_chunk = [this, triag_num, &chunk_bounds] (size_t c) {
+            for (size_t i = c * PARALLEL_BUILD_SIZE, end = std::min((c + 1) * PARALLEL_BUILD_SIZE, triag_num); i < end; ++i)
+                chunk_bounds[c].update(own_triags_[i].triag);
+        };
+
+        tasks::run_chunks(pool, chunk_num, calc_chunk);
+
+        max_min_crds_t min_max{};
+        for (auto &bounds : chunk_bounds) min_max.merge(bounds);
+
+        return {min_max.get_meanx(), min_max.get_meany(), min_max.get_meanz(), min_max.get_rad()};
+    }
+
+    void calc_build_boxes(tasks::task_pool_t *pool)
+    {
+        size_t triag_num = own_triags_.size();
+        size_t chunk_num = (triag_num + PARALLEL_BUILD_SIZE - 1) / PARALLEL_BUILD_SIZE;
+
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            build_lo_[axis].resize(triag_num);
+            build_hi_[axis].resize(triag_num);
+        }
+
+        tasks::run_chunks(pool, chunk_num, [this, triag_num] (size_t c) {
+            for (size_t i = c * PARALLEL_BUILD_SIZE, end = std::min((c + 1) * PARALLEL_BUILD_SIZE, triag_num); i < end; ++i)
+            {
+                max_min_crds_t box{};
+                box.update(own_triags_[i].triag);
+
+                for (int axis = 0; axis < 3; ++axis)
+                {
+                    build_lo_[axis][i] = box.get_min(axis);
+                    build_hi_[axis][i] = box.get_max(axis);
+                }
+            }
+        });
+    }
+
+/*==========================================================================*/
+
+    static size_t slot(cube_positions pos) { return (pos == BORDER) ? 0 : pos + 1; }
+
+    /**
+     * \brief slots of order_[from, from + num) in a tight tree, a batch of boxes is gathered and classified at once
+    */
+    void classify_boxes(const detail::node_classifier_t &classifier, index_t from, size_t num, uint8_t *slots) const
+    {
+        double lo[3][kernels::BATCH_SIZE], hi[3][kernels::BATCH_SIZE];
+
+        for (size_t done = 0; done < num; done += kernels::BATCH_SIZE)
+        {
+            size_t batch = std::min(kernels::BATCH_SIZE, num - done);
+
+            for (size_t k = 0; k < batch; ++k)
+            {
+                index_t triag = order_[from + done + k];
+
+                for (int axis = 0; axis < 3; ++axis)
+                {
+                    lo[axis][k] = build_lo_[axis][triag];
+                    hi[axis][k] = build_hi_[axis][triag];
+                }
+            }
+
+            kernels::child_slots({lo[0], lo[1], lo[2]}, {hi[0], hi[1], hi[2]}, batch, classifier.get_center(), slots + done);
+        }
+    }
+
+    /**
+     * \brief stable partition of order_[first, last) into border triags followed by the triags of every child,
+     *        returns bounds of these child_num+1 ranges. Chunks are classified in parallel when pool is given.
+    */
+    bounds_t partition(const node_position &pos, index_t first, index_t last, tasks::task_pool_t *pool)
+    {
+        detail::node_classifier_t classifier{pos, loose_factor_};
+
+        size_t size      = last - first;
+        size_t chunk_num = (size + PARALLEL_BUILD_SIZE - 1) / PARALLEL_BUILD_SIZE;
+
+        std::vector<uint8_t> slots(size);
+        std::vector<std::array<index_t, child_num+1>> counts(chunk_num);
+
+        auto classify_chunk = [&, first] (size_t c) {
+            size_t begin = c * PARALLEL_BUILD_SIZE, end = std::min((c + 1) * PARALLEL_BUILD_SIZE, size);
+
+            if (classifier.is_loose())
+                for (size_t i = begin; i < end; ++i) slots[i] = slot(classifier.check_triangle(own_triags_[order_[first + i]].triag));
+            else
+                classify_boxes(classifier, static_cast<index_t>(first + begin), end - begin, slots.data() + begin);
+
+            counts[c].fill(0);
+            for (size_t i = begin; i < end; ++i) ++counts[c][slots[i]];
+        };
+
+        std::vector<index_t> sorted(size);
+
+        auto scatter_chunk = [&, first] (size_t c, std::array<index_t, child_num+1> offsets) {
+            for (size_t i = c * PARALLEL_BUILD_SIZE, end = std::min((c + 1) * PARALLEL_BUILD_SIZE, size); i < end; ++i)
+                sorted[offsets[slots[i]]++] = order_[first + i];
+        };
+
+        tasks::run_chunks(pool, chunk_num, classify_chunk);
+
+        bounds_t bounds;
+        bounds[0] = first;
+        for (int s = 0; s < child_num+1; ++s)
+        {
+            bounds[s + 1] = bounds[s];
+            for (auto &count : counts) bounds[s + 1] += count[s];
+        }
+
+        std::vector<std::array<index_t, child_num+1>> offsets(chunk_num);
+        for (int s = 0; s < child_num+1; ++s)
+        {
+            index_t offset = bounds[s] - first;
+            for (size_t c = 0; c < chunk_num; ++c)
+            {
+                offsets[c][s] = offset;
+                offset += counts[c][s];
+            }
+        }
+
+        tasks::run_chunks(pool, chunk_num, [&] (size_t c) { scatter_chunk(c, offsets[c]); });
+
+        std::copy(sorted.begin(), sorted.end(), order_.begin() + first);
+
+        return bounds;
+    }
+
+/*==========================================================================*/
+
+    /**
+     * \brief splits nodes[idx] and appends its children, returns false for a leaf
+    */
+    bool split_node(std::vector<detail::node_t> &nodes, index_t idx, unsigned depth, tasks::task_pool_t *pool)
+    {
+        detail::node_t node = nodes[idx];
+
+        if (node.triag_num() < leaf_size_ || depth >= max_depth_) return false;
+
+        bounds_t bounds = partition(node.pos_, node.first_, node.last_, pool);
+
+        index_t child = static_cast<index_t>(nodes.size());
+
+        nodes[idx].border_ = bounds[1];
+        nodes[idx].child_  = child;
+
+        for (int i = 0; i < child_num; ++i)
+        {
+            detail::node_t child_node{};
+
+            child_node.pos_    = node.child_pos(i);
+            child_node.first_  = bounds[i + 1];
+            child_node.border_ = bounds[i + 1];
+            child_node.last_   = bounds[i + 2];
+
+            nodes.push_back(child_node);
+        }
+
+        return true;
+    }
+
+    void split(std::vector<detail::node_t> &nodes, index_t idx, unsigned depth)
+    {
+        if (!split_node(nodes, idx, depth, nullptr)) return;
+
+        index_t child = nodes[idx].child_;
+        for (int i = 0; i < child_num; ++i) split(nodes, child + i, depth + 1);
+    }
+
+    /**
+     * \brief children subtrees are built by fork-join tasks into their own arrays which are appended to nodes afterwards,
+     *        the result equals split()
+    */
+    void split_parallel(std::vector<detail::node_t> &nodes, index_t idx, unsigned depth, tasks::task_pool_t &pool)
+    {
+        if (!split_node(nodes, idx, depth, &pool)) return;
+
+        index_t child = nodes[idx].child_;
+
+        std::array<std::vector<detail::node_t>, child_num> subtrees;
+        tasks::task_group_t group;
+
+        for (int i = 0; i < child_num; ++i)
+        {
+            subtrees[i].push_back(nodes[child + i]);
+
+            pool.spawn(group, [this, i, depth, &subtrees, &pool] {
+                if (subtrees[i][0].triag_num() < PARALLEL_BUILD_SIZE)
+                    split(subtrees[i], 0, depth + 1);
+                else
+                    split_parallel(subtrees[i], 0, depth + 1, pool);
+            });
+        }
+
+        pool.wait(group);
+
+        for (int i = 0; i < child_num; ++i)
+            append_subtree(nodes, child + i, subtrees[i]);
+    }
+
+    void apply_order()
+    {
+        apply_permutation(own_triags_, order_);
+
+        std::vector<index_t>{}.swap(order_);
+
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            std::vector<double>{}.swap(build_lo_[axis]);
+            std::vector<double>{}.swap(build_hi_[axis]);
+        }
+    }
+
+    /**
+     * \brief tight bounding box of every subtree, children always follow their parent in own_nodes_ so one backward pass is enough
+    */
+    void calc_boxes()
+    {
+        own_boxes_.assign(own_nodes_.size(), max_min_crds_t{});
+
+        for (size_t idx = own_nodes_.size(); idx-- > 0;)
+        {
+            const detail::node_t &node = own_nodes_[idx];
+
+            index_t end = node.is_leaf() ? node.last_ : node.border_;
+            for (index_t i = node.first_; i < end; ++i) own_boxes_[idx].update(own_triags_[i].triag);
+
+            if (!node.is_leaf())
+                for (int i = 0; i < child_num; ++i) own_boxes_[idx].merge(own_boxes_[node.child_ + i]);
+        }
+    }
+
+    /**
+     * \brief builds trees over an evenly strided sample of own_triags_ for leaf sizes 2^3..2^10 and returns the one
+     *        with the smallest estimated cost. The sample tree with leaf size L * m / n has the shape of the full tree
+     *        with leaf size L, so its pair tests are scaled by (n / m)^2 and its classified triags by n / m.
+    */
+    size_t tune_leaf_size(const octree_params_t &params) const
+    {
+        size_t triag_num  = own_triags_.size();
+        size_t sample_num = std::min(triag_num, AUTO_TUNE_SAMPLE);
+
+        if (sample_num == 0) return SIZE_OF_PART;
+
+        triag_vector sample;
+        sample.reserve(sample_num);
+        for (size_t i = 0; i < sample_num; ++i) sample.push_back(own_triags_[i * triag_num / sample_num]);
+
+        double scale = static_cast<double>(triag_num) / sample_num;
+
+        size_t best_size = SIZE_OF_PART;
+        double best_cost = std::numeric_limits<double>::infinity();
+
+        for (size_t leaf_size = (1 << 3); leaf_size <= (1 << 10); leaf_size <<= 1)
+        {
+            size_t sample_leaf_size = static_cast<size_t>(leaf_size / scale);
+            if (sample_leaf_size < 2) continue;
+
+            octree_params_t sample_params = params;
+            sample_params.leaf_size = sample_leaf_size;
+
+            octree_t tree{sample, sample_params};
+
+            double cost = tree.pair_test_num() * scale * scale + AUTO_TUNE_NODE_COST * tree.node_num() +
+                          AUTO_TUNE_CLASSIFY_COST * tree.classified_num() * scale;
+
+            if (cost < best_cost) { best_cost = cost; best_size = leaf_size; }
+        }
+
+        return best_size;
+    }
+
+    void collect_stats(index_t idx, size_t depth, tree_stats_t &stats) const
+    {
+        const detail::node_t &node = nodes_[idx];
+
+        if (stats.depth_nodes.size() <= depth)
+        {
+            stats.depth_nodes.resize(depth + 1, 0);
+            stats.depth_borders.resize(depth + 1, 0);
+        }
+
+        ++stats.depth_nodes[depth];
+
+        if (node.is_leaf())
+        {
+            size_t triag_num = node.triag_num(), bucket = 0;
+            while (triag_num >> bucket) ++bucket;
+
+            if (stats.leaf_occupancy.size() <= bucket) stats.leaf_occupancy.resize(bucket + 1, 0);
+
+            ++stats.leaf_occupancy[bucket];
+            ++stats.leaf_num;
+            stats.max_leaf = std::max(stats.max_leaf, triag_num);
+            return;
+        }
+
+        stats.depth_borders[depth] += node.border_ - node.first_;
+
+        for (int i = 0; i < child_num; ++i) collect_stats(node.child_ + i, depth + 1, stats);
+    }
+
+    /**
+     * \brief triags moved into children while building, every internal node classifies all its triags
+    */
+    size_t classified_num() const
+    {
+        size_t num = 0;
+        for (auto &node : nodes_)
+            if (!node.is_leaf()) num += node.triag_num();
+
+        return num;
+    }
+
+    size_t pair_test_num(index_t idx) const
+    {
+        const detail::node_t &node = nodes_[idx];
+
+        size_t triag_num = node.triag_num();
+
+        if (node.is_leaf()) return triag_num * (triag_num - 1) / 2;
+
+        size_t border_num = node.border_ - node.first_;
+        size_t num = border_num * (triag_num - 1) - border_num * (border_num - 1) / 2;
+
+        for (int i = 0; i < child_num; ++i)
+        {
+            num += pair_test_num(node.child_ + i);
+
+            if (is_loose())
+                for (int j = i + 1; j < child_num; ++j)
+                    num += cross_test_num(node.child_ + i, node.child_ + j);
+        }
+
+        return num;
+    }
+
+    /**
+     * \brief mirrors cross_collisions()
+    */
+    size_t cross_test_num(index_t a, index_t b) const
+    {
+        const detail::node_t &na = nodes_[a];
+        const detail::node_t &nb = nodes_[b];
+
+        if (!boxes_[a].overlaps(boxes_[b], ACCURACY)) return 0;
+
+        if (na.is_leaf() && nb.is_leaf()) return static_cast<size_t>(na.triag_num()) * nb.triag_num();
+
+        size_t num = 0;
+
+        if (na.is_leaf() || (!nb.is_leaf() && nb.triag_num() > na.triag_num()))
+        {
+            num += static_cast<size_t>(nb.border_ - nb.first_) * na.triag_num();
+            for (int i = 0; i < child_num; ++i) num += cross_test_num(a, nb.child_ + i);
+            return num;
+        }
+
+        num += static_cast<size_t>(na.border_ - na.first_) * nb.triag_num();
+        for (int i = 0; i < child_num; ++i) num += cross_test_num(na.child_ + i, b);
+
+        return num;
+    }
+
+/*==========================================================================*/
+
+    /**
+     * \brief box that holds every triag of the subtree: the tight box of a loose tree,
+     *        the cube of a strict node since its triags are not cut by the center planes of its ancestors
+    */
+    max_min_crds_t node_box(index_t idx) const
+    {
+        if (is_loose()) return boxes_[idx];
+
+        const node_position &pos = nodes_[idx].pos_;
+
+        max_min_crds_t box{};
+        box.update(pos.x_ - pos.rad_, pos.y_ - pos.rad_, pos.z_ - pos.rad_);
+        box.update(pos.x_ + pos.rad_, pos.y_ + pos.rad_, pos.z_ + pos.rad_);
+
+        return box;
+    }
+
+    /**
+     * \brief calls func(i) for every i in [0, num), chunks of QUERY_TASK_SIZE are run in parallel when thread_num > 1
+    */
+    template <typename F>
+    static void run_batch(size_t num, size_t thread_num, F func)
+    {
+        auto run_chunk = [num, &func] (size_t c) {
+            for (size_t i = c * QUERY_TASK_SIZE, end = std::min((c + 1) * QUERY_TASK_SIZE, num); i < end; ++i) func(i);
+        };
+
+        size_t chunk_num = (num + QUERY_TASK_SIZE - 1) / QUERY_TASK_SIZE;
+
+        if (thread_num > 1 && chunk_num > 1)
+        {
+            tasks::task_pool_t pool{thread_num};
+            tasks::run_chunks(&pool, chunk_num, run_chunk);
+        }
+        else
+            tasks::run_chunks(nullptr, chunk_num, run_chunk);
+    }
+
+    void cast_ray(index_t idx, const ray_t &ray, const detail::crds_t &origin, const detail::crds_t &dir,
+                  ray_mode mode, double &max_dist, std::vector<ray_hit_t> &hits) const
+    {
+        const detail::node_t &node = nodes_[idx];
+
+        index_t end = node.is_leaf() ? node.last_ : node.border_;
+
+        for (index_t i = node.first_; i < end; ++i)
+        {
+            if (std::isnan(detail::ray_box_entry(origin, dir, triag_box(i), max_dist, ACCURACY))) continue;
+
+            double dist = all_triags_[i].triag.intersect_ray(ray);
+            if (!(dist <= max_dist)) continue;
+
+            if (mode == ALL_HITS) { hits.push_back({all_triags_[i].id, dist}); continue; }
+
+            hits.assign(1, {all_triags_[i].id, dist});
+            max_dist = dist;
+
+            if (mode == ANY_HIT) return;
+        }
+
+        if (node.is_leaf()) return;
+
+        std::array<std::pair<double, index_t>, child_num> order;
+        int num = 0;
+
+        for (int i = 0; i < child_num; ++i)
+        {
+            double entry = detail::ray_box_entry(origin, dir, node_box(node.child_ + i), max_dist, ACCURACY);
+            if (std::isnan(entry)) continue;
+
+            int pos = num++;
+            for (; pos > 0 && order[pos - 1].first > entry; --pos) order[pos] = order[pos - 1];
+
+            order[pos] = {entry, node.child_ + i};
+        }
+
+        for (int i = 0; i < num; ++i)
+        {
+            if (order[i].first > max_dist) break;
+
+            cast_ray(order[i].second, ray, origin, dir, mode, max_dist, hits);
+
+            if (mode == ANY_HIT && !hits.empty()) return;
+        }
+    }
+
+    template <typename shape_t>
+    void query(index_t idx, const shape_t &shape, const max_min_crds_t &shape_box, std::vector<size_t> &ids) const
+    {
+        const detail::node_t &node = nodes_[idx];
+
+        if (!node_box(idx).overlaps(shape_box, ACCURACY)) return;
+
+        index_t end = node.is_leaf() ? node.last_ : node.border_;
+
+        for (index_t i = node.first_; i < end; ++i)
+        {
+            if (!triag_box(i).overlaps(shape_box, ACCURACY)) continue;
+
+            const triag_id_t &it = all_triags_[i];
+            if (detail::hits(it.triag, shape)) ids.push_back(it.id);
+        }
+
+        if (node.is_leaf()) return;
+
+        for (int i = 0; i < child_num; ++i) query(node.child_ + i, shape, shape_box, ids);
+    }
+
+/*==========================================================================*/
+
+    template <typename answer_t>
+    void get_collisions(index_t idx, answer_t &answer) const
+    {
+        const detail::node_t &node = nodes_[idx];
+
+        if (node.is_leaf()) { leaf_collisions(node, answer); return; }
+
+        for (int i = 0; i < child_num; i++)
+            get_collisions(node.child_ + i, answer);
+
+        border_collisions(node, node.first_, node.border_, answer);
+
+        if (is_loose())
+            for (int i = 0; i < child_num; ++i)
+                for (int j = i + 1; j < child_num; ++j)
+                    cross_collisions(node.child_ + i, node.child_ + j, answer);
+    }
+
+    /**
+     * \brief spawns leaves and chunks of border lists as separate tasks, each task writes to answers[worker_id]
+    */
+    template <typename answer_t>
+    void get_collisions(index_t idx, tasks::task_pool_t &pool, tasks::task_group_t &group, std::vector<answer_t> &answers) const
+    {
+        const detail::node_t &node = nodes_[idx];
+
+        if (node.is_leaf())
+        {
+            pool.spawn(group, [this, &node, &pool, &answers] { leaf_collisions(node, answers[pool.worker_id()]); });
+            return;
+        }
+
+        for (int i = 0; i < child_num; i++)
+        {
+            index_t child = node.child_ + i;
+            pool.spawn(group, [this, child, &pool, &group, &answers] { get_collisions(child, pool, group, answers); });
+        }
+
+        for (index_t i = node.first_; i < node.border_; i += BORDER_TASK_SIZE)
+        {
+            index_t end = std::min<index_t>(i + BORDER_TASK_SIZE, node.border_);
+
+            pool.spawn(group, [this, &node, i, end, &pool, &answers] { border_collisions(node, i, end, answers[pool.worker_id()]); });
+        }
+
+        if (!is_loose()) return;
+
+        for (int i = 0; i < child_num; ++i)
+            for (int j = i + 1; j < child_num; ++j)
+            {
+                index_t a = node.child_ + i, b = node.child_ + j;
+                if (boxes_[a].overlaps(boxes_[b], ACCURACY))
+                    pool.spawn(group, [this, a, b, &pool, &answers] { cross_collisions(a, b, answers[pool.worker_id()]); });
+            }
+    }
+
+    /**
+     * \brief tests every triag of subtree a against every triag of subtree b, pairs of subtrees with disjoint boxes are skipped
+    */
+    template <typename answer_t>
+    void cross_collisions(index_t a, index_t b, answer_t &answer) const
+    {
+        const detail::node_t &na = nodes_[a];
+        const detail::node_t &nb = nodes_[b];
+
+        if (!boxes_[a].overlaps(boxes_[b], ACCURACY)) return;
+
+        if (na.is_leaf() && nb.is_leaf())
+        {
+            range_collisions(na.first_, na.last_, nb.first_, nb.last_, answer);
+            return;
+        }
+
+        if (na.is_leaf() || (!nb.is_leaf() && nb.triag_num() > na.triag_num()))
+        {
+            range_collisions(nb.first_, nb.border_, na.first_, na.last_, answer);
+            for (int i = 0; i < child_num; ++i) cross_collisions(a, nb.child_ + i, answer);
+            return;
+        }
+
+        range_collisions(na.first_, na.border_, nb.first_, nb.last_, answer);
+        for (int i = 0; i < child_num; ++i) cross_collisions(na.child_ + i, b, answer);
+    }
+
+    /**
+     * \brief tests all_triags_[i] against all_triags_[begin, end) one pair at a time, used for the answers that count every pair
+    */
+    template <typename answer_t>
+    void test_range(index_t i, index_t begin, index_t end, answer_t &answer) const
+    {
+        for (index_t j = begin; j < end; ++j) test_pair(all_triags_[i], all_triags_[j], answer);
+    }
+
+    /**
+     * \brief batched narrow phase over block (block_ or float_block_): mask_of(query, first, num) drops whole lanes
+     *        of candidates and only the rest go to test_pair() with the full triangle_t
+    */
+    template <typename block_t, typename answer_t, typename F>
+    void test_batched(const block_t &block, index_t i, index_t begin, index_t end, answer_t &answer, F mask_of) const
+    {
+        if (begin >= end) return;
+
+        kernels::basic_query_t<typename block_t::value_type> query{block, i};
+
+        for (index_t first = begin; first < end; first += kernels::BATCH_SIZE)
+        {
+            size_t num = std::min<size_t>(kernels::BATCH_SIZE, end - first);
+
+            for (uint64_t mask = mask_of(query, first, num); mask; mask &= mask - 1)
+                test_pair(all_triags_[i], all_triags_[first + __builtin_ctzll(mask)], answer);
+        }
+    }
+
+    template <typename answer_t>
+    void test_filtered(index_t i, index_t begin, index_t end, answer_t &answer) const
+    {
+        auto filter = [&] (const auto &block) {
+            test_batched(block, i, begin, end, answer, [&block] (const auto &query, size_t first, size_t num) {
+                return kernels::filter_mask(query, block, first, num);
+            });
+        };
+
+        if (float_filter_) filter(float_block_);
+        else               filter(block_);
+    }
+
+    void test_range(index_t i, index_t begin, index_t end, std::vector<bool> &answer) const
+    {
+        test_filtered(i, begin, end, answer);
+    }
+
+    void test_range(index_t i, index_t begin, index_t end, pair_vector &pairs) const
+    {
+        test_filtered(i, begin, end, pairs);
+    }
+
+    /**
+     * \brief filter_mask() is tuned to the tolerance of intersects(), the exact test gets the exact box filter
+    */
+    void test_range(index_t i, index_t begin, index_t end, exact_answer_t &answer) const
+    {
+        auto filter = [&] (const auto &block) {
+            test_batched(block, i, begin, end, answer, [&block] (const auto &query, size_t first, size_t num) {
+                return kernels::box_mask(query, block, first, num);
+            });
+        };
+
+        if (float_filter_) filter(float_block_);
+        else               filter(block_);
+    }
+
+    template <typename answer_t>
+    void range_collisions(index_t begin1, index_t end1, index_t begin2, index_t end2, answer_t &answer) const
+    {
+        for (index_t i = begin1; i < end1; ++i) test_range(i, begin2, end2, answer);
+    }
+
+    template <typename answer_t>
+    void leaf_collisions(const detail::node_t &node, answer_t &answer) const
+    {
+        for (index_t i = node.first_; i < node.last_; ++i) test_range(i, i + 1, node.last_, answer);
+    }
+
+    template <typename answer_t>
+    void border_collisions(const detail::node_t &node, index_t begin, index_t end, answer_t &answer) const
+    {
+        /* border triags go first, so the pairs of two border triags are tested once, by the first of them */
+        for (index_t i = begin; i < end; ++i) test_range(i, i + 1, node.last_, answer);
+    }
 };
 
 }
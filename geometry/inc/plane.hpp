@@ -11,36 +11,122 @@ enum mutual_pos
     EQUAL
 };
 
-class plane_t
+template <typename real_t>
+class basic_plane_t
 {
-    double a_ = NAN, b_ = NAN, c_ = NAN, d_ = NAN;
+    using point_type  = basic_point_t<real_t>;
+    using vector_type = basic_vector_t<real_t>;
+    using line_type   = basic_line_t<real_t>;
 
-    vector_t norm_vec_;
-    point_t  plane_pnt_;
+    /* the normal is (a_, b_, c_) and the point only gives d_, neither is kept twice so a triangle_t stays small */
+    real_t a_ = NAN, b_ = NAN, c_ = NAN, d_ = NAN;
 
     public:
 
-    plane_t(const vector_t &norm_vec, const point_t &plane_pnt);
+    constexpr basic_plane_t(const vector_type &norm_vec, const point_type &plane_pnt) :
+    a_(norm_vec.get_x()), b_(norm_vec.get_y()), c_(norm_vec.get_z()),
+    d_(-1 * (a_ * plane_pnt.get_x() + b_ * plane_pnt.get_y() + c_ * plane_pnt.get_z())) {}
 
-    bool is_valid() const { return norm_vec_.is_valid() && plane_pnt_.is_valid(); }
+    constexpr bool is_valid() const { return is_finite(a_) && is_finite(b_) && is_finite(c_) && is_finite(d_); }
 
-    mutual_pos get_mutual_pos_type(const plane_t &pln, const point_t &pnt) const;
+    constexpr mutual_pos get_mutual_pos_type(const basic_plane_t &pln, const point_type &pnt) const
+    {
+        ASSERT(is_valid());
+        ASSERT(pln.is_valid());
+        ASSERT(pnt.is_valid());
 
-    point_t get_line_intersection(const line_t &line) const;
+        vector_type res_vec = get_norm().vec_product(pln.get_norm());
 
-    line_t get_intersection(const plane_t &plane) const;
+        if (res_vec != null_vec<real_t>) return INTERSECT;
 
-    double calc_point(const point_t &pnt) const;
+        if (is_equal(pln.a_ * pnt.get_x() + pln.b_ * pnt.get_y() + pln.c_ * pnt.get_z() + pln.d_, 0))
+            return EQUAL;
 
-    void print() const;
+        return PARALLEL;
+    }
 
+    constexpr point_type get_line_intersection(const line_type &line) const
+    {
+        ASSERT(is_valid());
+        ASSERT(line.is_valid());
 
-    double get_a() const { return a_; }
-    double get_b() const { return b_; }
-    double get_c() const { return c_; }
-    double get_d() const { return d_; }
+        if (is_equal(get_norm().sqal_product(line.get_dir_vec()), 0))
+        {
+            if (is_equal(calc_point(line.get_line_pnt()), 0)) return spec_pnt<real_t>;
+            return nan_pnt<real_t>;
+        }
 
-    vector_t get_norm() const { return norm_vec_; }
+        vector_type dir_vec = line.get_dir_vec();
+        point_type pnt = line.get_line_pnt();
+
+        real_t denom = a_ * dir_vec.get_x() + b_ * dir_vec.get_y() + c_ * dir_vec.get_z();
+        real_t t0 = -1 * calc_point(pnt) / denom;
+
+
+        return {pnt.get_x() + dir_vec.get_x() * t0, pnt.get_y() + dir_vec.get_y() * t0, pnt.get_z() + dir_vec.get_z() * t0};
+    }
+
+    constexpr line_type get_intersection(const basic_plane_t &plane2) const
+    {
+        ASSERT(is_valid());
+        ASSERT(plane2.is_valid());
+
+        real_t main_det = b_ * plane2.c_ - plane2.b_ * c_;
+        if (!is_equal(main_det, 0))
+        {
+            real_t sub_det1 = plane2.d_ * c_ - d_ * plane2.c_;
+            real_t sub_det2 = plane2.b_ * d_ - b_ * plane2.d_;
+
+            return line_type{{get_norm().vec_product(plane2.get_norm())}, {0, (sub_det1 / main_det), (sub_det2 / main_det)}};
+        }
+
+        main_det = a_ * plane2.c_ - plane2.a_ * c_;
+        if (!is_equal(main_det, 0))
+        {
+            real_t sub_det1 = plane2.d_ * c_ - d_ * plane2.c_;
+            real_t sub_det2 = plane2.a_ * d_ - a_ * plane2.d_;
+
+            return line_type{{get_norm().vec_product(plane2.get_norm())}, {(sub_det1 / main_det), 0, (sub_det2 / main_det)}};
+        }
+
+        main_det = a_ * plane2.b_ - plane2.a_ * b_;
+        if(!is_equal(main_det, 0))
+        {
+            real_t sub_det1 = plane2.d_ * b_ - d_ * plane2.b_;
+            real_t sub_det2 = plane2.a_ * d_ - a_ * plane2.d_;
+
+            return line_type{{get_norm().vec_product(plane2.get_norm())}, {(sub_det1 / main_det), (sub_det2 / main_det), 0}};
+        }
+
+        return {nan_vec<real_t>, nan_pnt<real_t>};
+    }
+
+    constexpr real_t calc_point(const point_type &pnt) const
+    {
+        ASSERT(is_valid());
+        ASSERT(pnt.is_valid());
+
+        return a_ * pnt.get_x() + b_ * pnt.get_y() + c_ * pnt.get_z() + d_;
+    }
+
+    void print() const
+    {
+        std::cout << "PLANE\nnorm vec = ";
+
+        get_norm().print();
+
+        std::cout << "d = " << d_ << std::endl;
+    }
+
+
+    constexpr real_t get_a() const { return a_; }
+    constexpr real_t get_b() const { return b_; }
+    constexpr real_t get_c() const { return c_; }
+    constexpr real_t get_d() const { return d_; }
+
+    constexpr vector_type get_norm() const { return {a_, b_, c_}; }
 };
 
+using plane_t = basic_plane_t<double>;
+
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cmath>
+#include <cstdint>
 #include <iostream>
 #include "custom_assert.hpp"
 #include "double_operations.hpp"
@@ -9,17 +10,27 @@ using namespace doperations;
 
 namespace geometry {
 
-class point_t
+/**
+ * \brief point over real_t, the comparison takes accuracy<real_t> as its tolerance
+*/
+template <typename real_t>
+class basic_point_t
 {
-    double x_, y_, z_;
+    real_t x_, y_, z_;
 
     public:
 
-    point_t(double x = NAN, double y = NAN, double z = NAN) : x_(x), y_(y), z_(z) {}
+    using value_type = real_t;
 
-    bool is_valid() const { return (std::isfinite(x_) && std::isfinite(y_) && std::isfinite(z_)); }
+    constexpr basic_point_t(real_t x = NAN, real_t y = NAN, real_t z = NAN) : x_(x), y_(y), z_(z) {}
 
-    bool operator== (const point_t &pnt) const
+    template <typename other_t>
+    constexpr explicit basic_point_t(const basic_point_t<other_t> &pnt) :
+        x_(static_cast<real_t>(pnt.get_x())), y_(static_cast<real_t>(pnt.get_y())), z_(static_cast<real_t>(pnt.get_z())) {}
+
+    constexpr bool is_valid() const { return (is_finite(x_) && is_finite(y_) && is_finite(z_)); }
+
+    constexpr bool operator== (const basic_point_t &pnt) const
     {
         ASSERT(is_valid());
         ASSERT(pnt.is_valid());
@@ -27,19 +38,43 @@ class point_t
         return (is_equal(x_, pnt.x_) && is_equal(y_, pnt.y_) && is_equal(z_, pnt.z_));
     }
 
-    bool operator!= (const point_t &pnt) const { return !(*this == pnt); }
+    constexpr bool operator!= (const basic_point_t &pnt) const { return !(*this == pnt); }
 
-    bool special_check() const { return (!std::isfinite(x_)) && std::isfinite(y_) && std::isfinite(z_); }
+    constexpr bool special_check() const { return (!is_finite(x_)) && is_finite(y_) && is_finite(z_); }
 
     void print() const { std::cout << "(" << x_ << ", " << y_ << ", " << z_ << ")" << std::endl; }
 
-    double get_x() const { return x_; }
-    double get_y() const { return y_; }
-    double get_z() const { return z_; }
+    constexpr real_t get_x() const { return x_; }
+    constexpr real_t get_y() const { return y_; }
+    constexpr real_t get_z() const { return z_; }
+};
+
+using point_t = basic_point_t<double>;
+
+/**
+ * \brief point of an integer grid, the coordinates count grid steps
+*/
+class int_point_t
+{
+    int64_t x_, y_, z_;
+
+    public:
+
+    int_point_t(int64_t x = 0, int64_t y = 0, int64_t z = 0) : x_(x), y_(y), z_(z) {}
+
+    bool operator== (const int_point_t &pnt) const { return x_ == pnt.x_ && y_ == pnt.y_ && z_ == pnt.z_; }
+
+    int64_t get_x() const { return x_; }
+    int64_t get_y() const { return y_; }
+    int64_t get_z() const { return z_; }
 };
 
-const point_t NAN_PNT  = {NAN, NAN, NAN};
-const point_t SPEC_PNT = {NAN, 0, 0};
-const point_t NULL_PNT = {0, 0, 0};
+template <typename real_t> constexpr basic_point_t<real_t> nan_pnt  = {NAN, NAN, NAN};
+template <typename real_t> constexpr basic_point_t<real_t> spec_pnt = {NAN, 0, 0};
+template <typename real_t> constexpr basic_point_t<real_t> null_pnt = {0, 0, 0};
+
+constexpr point_t NAN_PNT  = nan_pnt<double>;
+constexpr point_t SPEC_PNT = spec_pnt<double>;
+constexpr point_t NULL_PNT = null_pnt<double>;
 
 }
@@ -0,0 +1,266 @@
+#pragma once
+
+#include "point.hpp"
+#include <algorithm>
+#include <array>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+
+
+namespace predicates {
+
+using geometry::point_t;
+using geometry::int_point_t;
+
+using int128_t = __int128;
+
+const int MAX_INT_BITS = 40; // the integer predicates are exact while every |coordinate| < 2^MAX_INT_BITS
+
+namespace detail {
+
+const double EPS = DBL_EPSILON / 2; // half of the distance from 1 to the next double, the rounding error of one operation
+
+const double ORIENT2D_BOUND = (3 + 16 * EPS) * EPS; // error bounds of the floating point determinants relative to their
+const double ORIENT3D_BOUND = (7 + 56 * EPS) * EPS; // permanents, by J. R. Shewchuk "Adaptive Precision Floating-Point Arithmetic"
+
+/**
+ * \brief x + y == a + b exactly, x is the rounded sum
+*/
+inline void two_sum(double a, double b, double &x, double &y)
+{
+    x = a + b;
+
+    double b_virt = x - a;
+    double a_virt = x - b_virt;
+
+    y = (a - a_virt) + (b - b_virt);
+}
+
+/**
+ * \brief x + y == a * b exactly, x is the rounded product
+*/
+inline void two_product(double a, double b, double &x, double &y)
+{
+    x = a * b;
+    y = std::fma(a, b, -x);
+}
+
+/**
+ * \brief exact sum of at most N doubles that do not overlap, terms go by increasing magnitude and zeros are dropped,
+ *        so the last term has the sign of the sum
+*/
+template <size_t N>
+struct expansion_t
+{
+    std::array<double, N> terms;
+    size_t size = 0;
+
+    void push(double term) { if (term != 0) terms[size++] = term; }
+
+    int sign() const { return size ? ((terms[size - 1] > 0) - (terms[size - 1] < 0)) : 0; }
+};
+
+/**
+ * \brief h = e + b, returns the length of h. h may be e: a term is written only after it is read
+*/
+inline size_t grow_expansion(size_t e_len, const double *e, double b, double *h)
+{
+    size_t h_len = 0;
+    double q = b;
+
+    for (size_t i = 0; i < e_len; ++i)
+    {
+        double sum, err;
+        two_sum(q, e[i], sum, err);
+
+        if (err != 0) h[h_len++] = err;
+        q = sum;
+    }
+
+    if (q != 0) h[h_len++] = q;
+
+    return h_len;
+}
+
+/**
+ * \brief h += f, the caller guarantees that h has room for h.size + f.size terms
+*/
+template <size_t N, size_t M>
+void add_to(expansion_t<N> &h, const expansion_t<M> &f)
+{
+    for (size_t j = 0; j < f.size; ++j) h.size = grow_expansion(h.size, h.terms.data(), f.terms[j], h.terms.data());
+}
+
+template <size_t N, size_t M>
+expansion_t<N + M> sum(const expansion_t<N> &e, const expansion_t<M> &f)
+{
+    expansion_t<N + M> h;
+
+    std::copy(e.terms.begin(), e.terms.begin() + e.size, h.terms.begin());
+    h.size = e.size;
+
+    add_to(h, f);
+    return h;
+}
+
+template <size_t N>
+expansion_t<N> negate(expansion_t<N> e)
+{
+    for (size_t i = 0; i < e.size; ++i) e.terms[i] = -e.terms[i];
+    return e;
+}
+
+/**
+ * \brief e * b
+*/
+template <size_t N>
+expansion_t<2 * N> scale(const expansion_t<N> &e, double b)
+{
+    expansion_t<2 * N> h;
+    if (e.size == 0) return h;
+
+    double q, err;
+    two_product(e.terms[0], b, q, err);
+    h.push(err);
+
+    for (size_t i = 1; i < e.size; ++i)
+    {
+        double prod_hi, prod_lo, sum;
+
+        two_product(e.terms[i], b, prod_hi, prod_lo);
+
+        two_sum(q, prod_lo, sum, err);
+        h.push(err);
+
+        two_sum(prod_hi, sum, q, err);
+        h.push(err);
+    }
+
+    h.push(q);
+    return h;
+}
+
+template <size_t N, size_t M>
+expansion_t<2 * N * M> product(const expansion_t<N> &e, const expansion_t<M> &f)
+{
+    expansion_t<2 * N * M> h;
+
+    for (size_t j = 0; j < f.size; ++j) add_to(h, scale(e, f.terms[j]));
+
+    return h;
+}
+
+/**
+ * \brief exact a - b
+*/
+inline expansion_t<2> diff(double a, double b)
+{
+    double x, y;
+    two_sum(a, -b, x, y);
+
+    expansion_t<2> h;
+    h.push(y);
+    h.push(x);
+
+    return h;
+}
+
+inline int orient2d_exact(double ax, double ay, double bx, double by, double cx, double cy)
+{
+    expansion_t<2> acx = diff(ax, cx), acy = diff(ay, cy), bcx = diff(bx, cx), bcy = diff(by, cy);
+
+    return sum(product(acx, bcy), negate(product(acy, bcx))).sign();
+}
+
+inline int orient3d_exact(const point_t &a, const point_t &b, const point_t &c, const point_t &d)
+{
+    expansion_t<2> adx = diff(a.get_x(), d.get_x()), ady = diff(a.get_y(), d.get_y()), adz = diff(a.get_z(), d.get_z());
+    expansion_t<2> bdx = diff(b.get_x(), d.get_x()), bdy = diff(b.get_y(), d.get_y()), bdz = diff(b.get_z(), d.get_z());
+    expansion_t<2> cdx = diff(c.get_x(), d.get_x()), cdy = diff(c.get_y(), d.get_y()), cdz = diff(c.get_z(), d.get_z());
+
+    auto bc = product(sum(product(bdx, cdy), negate(product(cdx, bdy))), adz);
+    auto ca = product(sum(product(cdx, ady), negate(product(adx, cdy))), bdz);
+    auto ab = product(sum(product(adx, bdy), negate(product(bdx, ady))), cdz);
+
+    return sum(sum(bc, ca), ab).sign();
+}
+
+}
+
+/**
+ * \brief sign of (a - c) x (b - c): 1 if a, b, c go counterclockwise, -1 if clockwise, 0 if they are collinear.
+ *        The floating point determinant is used when its error bound proves the sign, the exact one otherwise
+*/
+inline int orient2d(double ax, double ay, double bx, double by, double cx, double cy)
+{
+    double left  = (ax - cx) * (by - cy);
+    double right = (ay - cy) * (bx - cx);
+    double det   = left - right;
+
+    double bound = detail::ORIENT2D_BOUND * (std::abs(left) + std::abs(right));
+
+    if (det >  bound) return  1;
+    if (det < -bound) return -1;
+
+    return detail::orient2d_exact(ax, ay, bx, by, cx, cy);
+}
+
+/**
+ * \brief sign of the determinant of the rows a - d, b - d, c - d: 1 if d is below the plane of a, b, c
+ *        ("above" is where a, b, c are seen counterclockwise from), -1 if above, 0 if the four points are coplanar.
+ *        The floating point determinant is used when its error bound proves the sign, the exact one otherwise
+*/
+inline int orient3d(const point_t &a, const point_t &b, const point_t &c, const point_t &d)
+{
+    double adx = a.get_x() - d.get_x(), ady = a.get_y() - d.get_y(), adz = a.get_z() - d.get_z();
+    double bdx = b.get_x() - d.get_x(), bdy = b.get_y() - d.get_y(), bdz = b.get_z() - d.get_z();
+    double cdx = c.get_x() - d.get_x(), cdy = c.get_y() - d.get_y(), cdz = c.get_z() - d.get_z();
+
+    double bdxcdy = bdx * cdy, cdxbdy = cdx * bdy;
+    double cdxady = cdx * ady, adxcdy = adx * cdy;
+    double adxbdy = adx * bdy, bdxady = bdx * ady;
+
+    double det = adz * (bdxcdy - cdxbdy) + bdz * (cdxady - adxcdy) + cdz * (adxbdy - bdxady);
+
+    double permanent = (std::abs(bdxcdy) + std::abs(cdxbdy)) * std::abs(adz) +
+                       (std::abs(cdxady) + std::abs(adxcdy)) * std::abs(bdz) +
+                       (std::abs(adxbdy) + std::abs(bdxady)) * std::abs(cdz);
+
+    double bound = detail::ORIENT3D_BOUND * permanent;
+
+    if (det >  bound) return  1;
+    if (det < -bound) return -1;
+
+    return detail::orient3d_exact(a, b, c, d);
+}
+
+/**
+ * \brief orient2d() of grid points. The differences take 41 bits and the products 82, int128_t holds them without rounding
+*/
+inline int orient2d(int64_t ax, int64_t ay, int64_t bx, int64_t by, int64_t cx, int64_t cy)
+{
+    int128_t det = static_cast<int128_t>(ax - cx) * (by - cy) - static_cast<int128_t>(ay - cy) * (bx - cx);
+
+    return (det > 0) - (det < 0);
+}
+
+/**
+ * \brief orient3d() of grid points, the determinant takes at most 126 bits
+*/
+inline int orient3d(const int_point_t &a, const int_point_t &b, const int_point_t &c, const int_point_t &d)
+{
+    int64_t adx = a.get_x() - d.get_x(), ady = a.get_y() - d.get_y(), adz = a.get_z() - d.get_z();
+    int64_t bdx = b.get_x() - d.get_x(), bdy = b.get_y() - d.get_y(), bdz = b.get_z() - d.get_z();
+    int64_t cdx = c.get_x() - d.get_x(), cdy = c.get_y() - d.get_y(), cdz = c.get_z() - d.get_z();
+
+    int128_t bc = static_cast<int128_t>(bdx) * cdy - static_cast<int128_t>(cdx) * bdy;
+    int128_t ca = static_cast<int128_t>(cdx) * ady - static_cast<int128_t>(adx) * cdy;
+    int128_t ab = static_cast<int128_t>(adx) * bdy - static_cast<int128_t>(bdx) * ady;
+
+    int128_t det = adz * bc + bdz * ca + cdz * ab;
+
+    return (det > 0) - (det < 0);
+}
+
+}
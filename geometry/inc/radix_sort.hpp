@@ -0,0 +1,75 @@
+#pragma once
+#include "task_pool.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+
+namespace sorts {
+
+const int    RADIX_BITS      = 8;
+const size_t RADIX_SIZE      = (1 << RADIX_BITS);
+const size_t RADIX_TASK_SIZE = (1 << 14); // keys handled by one task in a pass
+
+/**
+ * \brief stable LSD radix sort of keys with values attached, RADIX_BITS per pass. Every pass builds
+ *        per chunk histograms and scatters the chunks in parallel when pool is given. Passes where
+ *        all keys share the digit are skipped.
+*/
+template <typename value_t>
+void radix_sort(std::vector<uint64_t> &keys, std::vector<value_t> &values, tasks::task_pool_t *pool = nullptr)
+{
+    size_t size      = keys.size();
+    size_t chunk_num = (size + RADIX_TASK_SIZE - 1) / RADIX_TASK_SIZE;
+
+    std::vector<uint64_t> keys_tmp(size);
+    std::vector<value_t>  values_tmp(size);
+
+    std::vector<std::array<size_t, RADIX_SIZE>> counts(chunk_num);
+
+    for (int shift = 0; shift < 64; shift += RADIX_BITS)
+    {
+        auto get_digit = [shift] (uint64_t key) { return (key >> shift) & (RADIX_SIZE - 1); };
+
+        tasks::run_chunks(pool, chunk_num, [&] (size_t c) {
+            counts[c].fill(0);
+            for (size_t i = c * RADIX_TASK_SIZE, end = std::min((c + 1) * RADIX_TASK_SIZE, size); i < end; ++i)
+                ++counts[c][get_digit(keys[i])];
+        });
+
+        bool is_sorted = false;
+        size_t offset = 0;
+
+        for (size_t d = 0; d < RADIX_SIZE; ++d)
+        {
+            size_t digit_num = 0;
+
+            for (size_t c = 0; c < chunk_num; ++c)
+            {
+                size_t count = counts[c][d];
+                counts[c][d] = offset;
+                offset    += count;
+                digit_num += count;
+            }
+
+            if (digit_num == size) is_sorted = true;
+        }
+
+        if (is_sorted) continue;
+
+        tasks::run_chunks(pool, chunk_num, [&] (size_t c) {
+            for (size_t i = c * RADIX_TASK_SIZE, end = std::min((c + 1) * RADIX_TASK_SIZE, size); i < end; ++i)
+            {
+                size_t pos = counts[c][get_digit(keys[i])]++;
+                keys_tmp[pos]   = keys[i];
+                values_tmp[pos] = values[i];
+            }
+        });
+
+        keys.swap(keys_tmp);
+        values.swap(values_tmp);
+    }
+}
+
+}
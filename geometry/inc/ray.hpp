@@ -0,0 +1,45 @@
+#pragma once
+
+#include "vector.hpp"
+
+namespace geometry {
+
+/**
+ * \brief points origin + t * dir for t >= 0, dir does not have to be normalized and t is measured in its lengths
+*/
+template <typename real_t>
+class basic_ray_t
+{
+    using point_type  = basic_point_t<real_t>;
+    using vector_type = basic_vector_t<real_t>;
+
+    point_type  origin_;
+    vector_type dir_;
+
+    public:
+
+    basic_ray_t(const point_type &origin, const vector_type &dir) : origin_(origin), dir_(dir) {}
+
+    bool is_valid() const { return origin_.is_valid() && dir_.is_valid() && dir_ != null_vec<real_t>; }
+
+    point_type get_point(real_t t) const
+    {
+        return {origin_.get_x() + t * dir_.get_x(), origin_.get_y() + t * dir_.get_y(), origin_.get_z() + t * dir_.get_z()};
+    }
+
+    point_type  get_origin() const { return origin_; }
+
+    vector_type get_dir() const { return dir_; }
+
+    void print() const
+    {
+        std::cout << "ray: origin = ";
+        origin_.print();
+        std::cout << "dir = ";
+        dir_.print();
+    }
+};
+
+using ray_t = basic_ray_t<double>;
+
+}
@@ -0,0 +1,124 @@
+#pragma once
+#include "collisions.hpp"
+#include <algorithm>
+#include <ostream>
+#include <vector>
+
+
+namespace reports {
+
+const char* const triag_type_names[octrees::triag_type_num] = {"triag", "segment", "point"};
+
+/**
+ * \brief statistics of one collision search, tree is filled only for the octree engine
+*/
+struct report_t
+{
+    collisions::engine_type engine     = collisions::OCTREE;
+    size_t                  triag_num  = 0;
+    size_t                  thread_num = 1;
+    size_t                  colliding  = 0;
+
+    double                    parse_time = 0; // seconds, filled by the caller
+    collisions::phase_times_t times;
+    octrees::pair_stats_t     pairs;
+
+    bool                  has_tree = false;
+    octrees::tree_stats_t tree;
+};
+
+/**
+ * \brief runs the search with counting of the narrow phase, the counting makes the query time somewhat longer
+*/
+inline report_t collect_report(collisions::engine_type engine, const octrees::triag_vector &triags, const collisions::engine_params_t &params)
+{
+    report_t report;
+    report.engine     = engine;
+    report.triag_num  = triags.size();
+    report.thread_num = params.thread_num;
+
+    octrees::stats_answer_t answer{std::vector<bool>(triags.size(), false), {}};
+
+    if (engine == collisions::OCTREE)
+    {
+        auto start = collisions::detail::clock::now();
+        octrees::octree_t tree{triags, params.octree_params()};
+        report.times.build = collisions::detail::seconds_since(start);
+
+        start = collisions::detail::clock::now();
+        tree.get_collisions(answer, params.thread_num);
+        report.times.query = collisions::detail::seconds_since(start);
+
+        report.has_tree = true;
+        report.tree     = tree.get_stats();
+    }
+    else
+        report.times = collisions::find_collisions(engine, triags, answer, params);
+
+    report.pairs     = answer.stats;
+    report.colliding = static_cast<size_t>(std::count(answer.flags.begin(), answer.flags.end(), true));
+
+    return report;
+}
+
+/*==========================================================================*/
+
+namespace detail {
+
+inline void print_array(std::ostream &out, const std::vector<size_t> &values)
+{
+    out << "[";
+    for (size_t i = 0, num = values.size(); i < num; ++i) out << (i ? ", " : "") << values[i];
+    out << "]";
+}
+
+}
+
+inline void print_json(std::ostream &out, const report_t &report)
+{
+    const octrees::pair_stats_t &pairs = report.pairs;
+
+    size_t tested = pairs.candidates - pairs.skipped;
+    double sphere_share = tested ? static_cast<double>(pairs.sphere_rejected) / tested : 0;
+
+    out << "{\n";
+    out << "  \"engine\": \"" << collisions::engine_names[report.engine] << "\",\n";
+    out << "  \"triangles\": " << report.triag_num << ",\n";
+    out << "  \"threads\": " << report.thread_num << ",\n";
+    out << "  \"colliding\": " << report.colliding << ",\n";
+
+    out << "  \"time\": {\"parse\": " << report.parse_time << ", \"build\": " << report.times.build
+        << ", \"query\": " << report.times.query << "},\n";
+
+    out << "  \"pairs\": {\n";
+    out << "    \"candidates\": " << pairs.candidates << ",\n";
+    out << "    \"skipped_marked\": " << pairs.skipped << ",\n";
+    out << "    \"sphere_rejected\": " << pairs.sphere_rejected << ",\n";
+    out << "    \"sphere_rejected_share\": " << sphere_share << ",\n";
+    out << "    \"intersecting\": " << pairs.intersecting << ",\n";
+    out << "    \"dispatch\": {";
+
+    for (int i = 0; i < octrees::triag_type_num; ++i)
+        for (int j = 0; j < octrees::triag_type_num; ++j)
+            out << ((i || j) ? ", " : "") << "\"" << triag_type_names[i] << "-" << triag_type_names[j] << "\": " << pairs.dispatch[i][j];
+
+    out << "}\n  }";
+
+    if (report.has_tree)
+    {
+        const octrees::tree_stats_t &tree = report.tree;
+
+        out << ",\n  \"tree\": {\n";
+        out << "    \"nodes\": " << tree.node_num << ",\n";
+        out << "    \"leaves\": " << tree.leaf_num << ",\n";
+        out << "    \"max_leaf\": " << tree.max_leaf << ",\n";
+        out << "    \"depth_nodes\": ";     detail::print_array(out, tree.depth_nodes);    out << ",\n";
+        out << "    \"depth_borders\": ";   detail::print_array(out, tree.depth_borders);  out << ",\n";
+        out << "    \"leaf_occupancy\": ";  detail::print_array(out, tree.leaf_occupancy); out << "\n";
+        out << "  }";
+    }
+
+    out << "\n}" << std::endl;
+}
+
+}
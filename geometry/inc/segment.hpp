@@ -5,51 +5,63 @@
 
 namespace geometry {
 
-class segment_t
+template <typename real_t>
+class basic_segment_t
 {
-    point_t first_;
-    point_t second_;
+    using point_type  = basic_point_t<real_t>;
+    using vector_type = basic_vector_t<real_t>;
+    using line_type   = basic_line_t<real_t>;
+    using plane_type  = basic_plane_t<real_t>;
 
-    vector_t dir_vec_{vector_t{second_} - vector_t{first_}};
+    point_type first_;
+    point_type second_;
 
-    line_t seg_line_{dir_vec_, first_};
+    /* by components and not by operator-, so a segment of NAN points is built and rejected by is_valid() */
+    vector_type dir_vec_{second_.get_x() - first_.get_x(), second_.get_y() - first_.get_y(), second_.get_z() - first_.get_z()};
+
+    line_type seg_line_{dir_vec_, first_};
 
     public:
 
     /**
      * \brief works correctly only if components are lying in the same plane
     */
-    bool contains_inter_pnt(const point_t &pnt) const;
+    bool contains_inter_pnt(const point_type &pnt) const;
 
-    segment_t(const point_t &first, const point_t &second) : first_(first), second_(second) {}
+    basic_segment_t(const point_type &first, const point_type &second) : first_(first), second_(second) {}
 
     bool is_valid() const { return first_.is_valid() && second_.is_valid(); }
 
     /**
      * \brief works correctly only if segments are lying on the same line
     */
-    bool contains_inter_seg(const segment_t &seg2) const;
+    bool contains_inter_seg(const basic_segment_t &seg2) const;
 
     /**
      * \brief works correctly only if segments are lying in the same plane
     */
-    bool intersects_seg(const segment_t &seg2) const;
+    bool intersects_seg(const basic_segment_t &seg2) const;
 
     /**
      * \brief works correctly only if components are lying in the same plane
     */
-    point_t get_line_intersection(const line_t &line) const;
+    point_type get_line_intersection(const line_type &line) const;
 
-    point_t get_plane_intersection(const plane_t &pln) const;
+    point_type get_plane_intersection(const plane_type &pln) const;
 
-    vector_t get_dir_vec() const { return dir_vec_; }
+    const vector_type& get_dir_vec() const { return dir_vec_; }
 
-    line_t get_seg_line() const { return seg_line_; }
+    const line_type& get_seg_line() const { return seg_line_; }
 
     void print() const;
 
-    const point_t& get_fst() const { return first_; }
-    const point_t& get_snd() const { return second_; }
+    const point_type& get_fst() const { return first_; }
+    const point_type& get_snd() const { return second_; }
 };
 
+using segment_t = basic_segment_t<double>;
+
+extern template class basic_segment_t<double>;
+extern template class basic_segment_t<float>;
+
 }
@@ -0,0 +1,323 @@
+#pragma once
+#include "double_operations.hpp"
+#include "octree.hpp"
+#include "task_pool.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+
+namespace grids {
+
+using octrees::index_t;
+using octrees::max_min_crds_t;
+
+const int     CELL_BITS       = 21;                       // bits of one cell coordinate in a packed cell key
+const size_t  MAX_CELL_NUM    = (size_t{1} << CELL_BITS); // cells per axis
+const size_t  CELL_TASK_SIZE  = (1 << 12);                // grid entries or triags handled by one task in parallel get_collisions()
+const int64_t MAX_TRIAG_CELLS = (1 << 6);                 // bigger triags are put into a coarser level
+const double  LEVEL_FACTOR    = 4;                        // cell size of a level relative to the level below it
+
+/**
+ * \brief hierarchy of sparse uniform grids: cell size of level 0 is the median extent of triag boxes, every next level
+ *        has LEVEL_FACTOR times larger cells. A triag is put into the finest level where its box overlaps at most
+ *        MAX_TRIAG_CELLS cells, and into every cell of that level its box overlaps. Cells are runs of entries sorted
+ *        by packed cell coordinates, so only nonempty cells are stored. A pair of one level is tested only in the lowest
+ *        cell shared by both boxes. A triag is tested with the triags of coarser levels in the cells its box overlaps there,
+ *        again only in the lowest common cell, so every pair is tested once and large triags meet only their neighbours.
+*/
+class spatial_hash_t
+{
+    struct entry_t
+    {
+        uint64_t key;
+        index_t  triag;
+    };
+
+    struct level_t
+    {
+        double               cell_size;
+        std::vector<entry_t> entries;
+    };
+
+    using cell_t = std::array<int64_t, 3>;
+
+    octrees::triag_vector       triags_;
+    std::vector<max_min_crds_t> boxes_;
+    std::vector<level_t>        levels_;
+    std::vector<uint8_t>        level_of_; // level of every triag
+
+    std::array<double, 3> origin_ = {0, 0, 0};
+
+/*==========================================================================*/
+
+    cell_t get_cell(size_t level, double x, double y, double z) const
+    {
+        double cell_size = levels_[level].cell_size;
+
+        return {static_cast<int64_t>((x - origin_[0]) / cell_size),
+                static_cast<int64_t>((y - origin_[1]) / cell_size),
+                static_cast<int64_t>((z - origin_[2]) / cell_size)};
+    }
+
+    cell_t get_lo_cell(size_t level, index_t triag) const
+    {
+        const max_min_crds_t &box = boxes_[triag];
+        return get_cell(level, box.x_min - ACCURACY, box.y_min - ACCURACY, box.z_min - ACCURACY);
+    }
+
+    cell_t get_hi_cell(size_t level, index_t triag) const
+    {
+        const max_min_crds_t &box = boxes_[triag];
+        return get_cell(level, box.x_max + ACCURACY, box.y_max + ACCURACY, box.z_max + ACCURACY);
+    }
+
+    static uint64_t get_key(const cell_t &cell)
+    {
+        return (static_cast<uint64_t>(cell[0]) << (2 * CELL_BITS)) |
+               (static_cast<uint64_t>(cell[1]) << CELL_BITS) |
+                static_cast<uint64_t>(cell[2]);
+    }
+
+    static int64_t cell_num(const cell_t &lo, const cell_t &hi)
+    {
+        return (hi[0] - lo[0] + 1) * (hi[1] - lo[1] + 1) * (hi[2] - lo[2] + 1);
+    }
+
+    /**
+     * \brief median of the largest box sides, grown if the scene does not fit into MAX_CELL_NUM cells per axis
+    */
+    double choose_cell_size(const max_min_crds_t &scene) const
+    {
+        std::vector<double> extents(boxes_.size());
+
+        for (size_t i = 0, num = boxes_.size(); i < num; ++i)
+        {
+            const max_min_crds_t &box = boxes_[i];
+            extents[i] = triple_max(box.x_max - box.x_min, box.y_max - box.y_min, box.z_max - box.z_min);
+        }
+
+        auto median = extents.begin() + extents.size() / 2;
+        std::nth_element(extents.begin(), median, extents.end());
+
+        double scene_size = 2 * scene.get_rad() + 4 * ACCURACY;
+        double min_size   = scene_size / (MAX_CELL_NUM - 2);
+
+        return std::max({*median, min_size, ACCURACY});
+    }
+
+    /**
+     * \brief the pair is tested in cell of level only if cell is the lowest cell of level covered by both boxes
+    */
+    bool is_lowest_common_cell(size_t level, index_t a, index_t b, uint64_t key) const
+    {
+        cell_t lo_a = get_lo_cell(level, a), lo_b = get_lo_cell(level, b);
+
+        return get_key({std::max(lo_a[0], lo_b[0]), std::max(lo_a[1], lo_b[1]), std::max(lo_a[2], lo_b[2])}) == key;
+    }
+
+    template <typename answer_t>
+    void cell_collisions(size_t level, size_t begin, size_t end, answer_t &answer) const
+    {
+        const std::vector<entry_t> &entries = levels_[level].entries;
+
+        for (size_t i = begin; i < end; ++i) {
+            const octrees::triag_id_t &it = triags_[entries[i].triag];
+
+            for (size_t j = i + 1; j < end; ++j) {
+                index_t a = entries[i].triag, b = entries[j].triag;
+
+                if (!boxes_[a].overlaps(boxes_[b], ACCURACY)) continue;
+                if (!is_lowest_common_cell(level, a, b, entries[i].key)) continue;
+
+                const octrees::triag_id_t &jt = triags_[b];
+
+                octrees::test_pair(it, jt, answer);
+            }
+        }
+    }
+
+    /**
+     * \brief handles every cell of level that starts in [begin, end) of its entries
+    */
+    template <typename answer_t>
+    void collisions(size_t level, size_t begin, size_t end, answer_t &answer) const
+    {
+        const std::vector<entry_t> &entries = levels_[level].entries;
+        size_t num = entries.size();
+
+        while (begin > 0 && begin < num && entries[begin - 1].key == entries[begin].key) ++begin;
+
+        for (size_t first = begin; first < end && first < num;)
+        {
+            size_t last = first + 1;
+            while (last < num && entries[last].key == entries[first].key) ++last;
+
+            cell_collisions(level, first, last, answer);
+            first = last;
+        }
+    }
+
+    /**
+     * \brief triag a is tested with the triags of every coarser level in the cells its box overlaps there.
+     *        Cells of a coarser level are larger, so the box overlaps about as few of them as in its own level
+    */
+    template <typename answer_t>
+    void coarser_collisions(index_t a, answer_t &answer) const
+    {
+        const octrees::triag_id_t &it = triags_[a];
+
+        for (size_t level = level_of_[a] + 1, level_num = levels_.size(); level < level_num; ++level)
+        {
+            const std::vector<entry_t> &entries = levels_[level].entries;
+            if (entries.empty()) continue;
+
+            cell_t lo = get_lo_cell(level, a), hi = get_hi_cell(level, a);
+
+            for (int64_t x = lo[0]; x <= hi[0]; ++x)
+                for (int64_t y = lo[1]; y <= hi[1]; ++y)
+                    for (int64_t z = lo[2]; z <= hi[2]; ++z)
+                    {
+                        uint64_t key = get_key({x, y, z});
+
+                        auto first = std::lower_bound(entries.begin(), entries.end(), key,
+                                                      [] (const entry_t &entry, uint64_t k) { return entry.key < k; });
+
+                        for (auto entry = first; entry != entries.end() && entry->key == key; ++entry)
+                        {
+                            index_t b = entry->triag;
+
+                            if (!boxes_[a].overlaps(boxes_[b], ACCURACY)) continue;
+                            if (!is_lowest_common_cell(level, a, b, key)) continue;
+
+                            octrees::test_pair(it, triags_[b], answer);
+                        }
+                    }
+        }
+    }
+
+    template <typename answer_t>
+    void all_collisions(answer_t &answer) const
+    {
+        for (size_t level = 0, level_num = levels_.size(); level < level_num; ++level)
+            collisions(level, 0, levels_[level].entries.size(), answer);
+
+        if (levels_.size() > 1)
+            for (index_t a = 0, num = static_cast<index_t>(triags_.size()); a < num; ++a) coarser_collisions(a, answer);
+    }
+
+/*==========================================================================*/
+
+    public:
+
+    spatial_hash_t(octrees::triag_vector triags) : triags_(std::move(triags))
+    {
+        index_t triag_num = static_cast<index_t>(triags_.size());
+        if (triag_num == 0) return;
+
+        max_min_crds_t scene{};
+
+        boxes_.resize(triag_num);
+        for (index_t i = 0; i < triag_num; ++i)
+        {
+            boxes_[i].update(triags_[i].triag);
+            scene.merge(boxes_[i]);
+        }
+
+        origin_ = {scene.x_min - 2 * ACCURACY, scene.y_min - 2 * ACCURACY, scene.z_min - 2 * ACCURACY};
+
+        /* the top level has cells larger than the scene, so every triag fits some level */
+        double scene_size = 2 * scene.get_rad() + 4 * ACCURACY;
+
+        levels_.push_back({choose_cell_size(scene), {}});
+        while (levels_.back().cell_size < scene_size) levels_.push_back({levels_.back().cell_size * LEVEL_FACTOR, {}});
+
+        level_of_.assign(triag_num, 0);
+
+        for (index_t i = 0; i < triag_num; ++i)
+        {
+            size_t level = 0;
+            while (level + 1 < levels_.size() && cell_num(get_lo_cell(level, i), get_hi_cell(level, i)) > MAX_TRIAG_CELLS) ++level;
+
+            level_of_[i] = static_cast<uint8_t>(level);
+
+            cell_t lo = get_lo_cell(level, i), hi = get_hi_cell(level, i);
+
+            for (int64_t x = lo[0]; x <= hi[0]; ++x)
+                for (int64_t y = lo[1]; y <= hi[1]; ++y)
+                    for (int64_t z = lo[2]; z <= hi[2]; ++z)
+                        levels_[level].entries.push_back({get_key({x, y, z}), i});
+        }
+
+        for (level_t &level : levels_)
+            std::sort(level.entries.begin(), level.entries.end(), [] (const entry_t &a, const entry_t &b) {
+                return (a.key < b.key) || (a.key == b.key && a.triag < b.triag);
+            });
+
+        /* empty levels on top are never looked up */
+        while (levels_.size() > 1 && levels_.back().entries.empty()) levels_.pop_back();
+    }
+
+    double get_cell_size() const { return levels_.empty() ? 1 : levels_[0].cell_size; }
+
+    size_t level_num() const { return levels_.size(); }
+
+    size_t entry_num() const
+    {
+        size_t num = 0;
+        for (const level_t &level : levels_) num += level.entries.size();
+
+        return num;
+    }
+
+    /**
+     * \brief flag mode, answer_t is std::vector<bool> or stats_answer_t
+    */
+    template <typename answer_t>
+    void get_collisions(answer_t &answer) const { all_collisions(answer); }
+
+    /**
+     * \brief appends every intersecting pair of ids, pairs are sorted and unique
+    */
+    void get_collisions(octrees::pair_vector &pairs) const { all_collisions(pairs); octrees::sort_pairs(pairs); }
+
+    /**
+     * \brief entries of every level are split into chunks of CELL_TASK_SIZE, a cell belongs to the chunk it starts in.
+     *        Tests with coarser levels are run in chunks of CELL_TASK_SIZE triags
+    */
+    template <typename answer_t>
+    void get_collisions(answer_t &answer, size_t thread_num) const
+    {
+        if (thread_num <= 1) { get_collisions(answer); return; }
+
+        tasks::task_pool_t pool{thread_num};
+
+        std::vector<answer_t> answers = octrees::make_answers(answer, pool.thread_num());
+
+        for (size_t level = 0, level_num = levels_.size(); level < level_num; ++level)
+        {
+            size_t entry_num = levels_[level].entries.size();
+            size_t chunk_num = (entry_num + CELL_TASK_SIZE - 1) / CELL_TASK_SIZE;
+
+            tasks::run_chunks(&pool, chunk_num, [this, level, entry_num, &pool, &answers] (size_t c) {
+                collisions(level, c * CELL_TASK_SIZE, std::min((c + 1) * CELL_TASK_SIZE, entry_num), answers[pool.worker_id()]);
+            });
+        }
+
+        if (levels_.size() > 1)
+        {
+            size_t triag_num = triags_.size();
+            size_t chunk_num = (triag_num + CELL_TASK_SIZE - 1) / CELL_TASK_SIZE;
+
+            tasks::run_chunks(&pool, chunk_num, [this, triag_num, &pool, &answers] (size_t c) {
+                for (size_t a = c * CELL_TASK_SIZE, end = std::min((c + 1) * CELL_TASK_SIZE, triag_num); a < end; ++a)
+                    coarser_collisions(static_cast<index_t>(a), answers[pool.worker_id()]);
+            });
+        }
+
+        octrees::merge_answers(answers, answer);
+    }
+};
+
+}
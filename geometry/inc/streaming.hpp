@@ -0,0 +1,342 @@
+#pragma once
+#include "double_operations.hpp"
+#include "collisions.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <istream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+namespace streaming {
+
+using octrees::max_min_crds_t;
+
+const size_t TILE_BYTES_PER_TRIAG = 4 * sizeof(octrees::triag_id_t); // memory taken by one triag while an engine runs on a tile
+const int    MAX_TILE_SPLIT       = 6;                                // a tile is split into at most MAX_TILE_SPLIT^3 subtiles
+const int    MAX_TILE_DEPTH       = 8;                                // deeper tiles are processed whatever their size
+const size_t TILE_READ_SIZE       = (1 << 12);                        // records read from a tile file at once
+const size_t MAX_HALO_FACTOR      = 4;                                // a split that copies triags more times than this is dropped
+
+struct stream_params_t
+{
+    size_t      memory_budget = (size_t{1} << 30); // bytes for the triags of one tile
+    std::string tmp_dir       = ".";               // tile files are kept in a new directory inside it
+};
+
+struct stream_stats_t
+{
+    size_t triag_num = 0;
+    size_t tile_num  = 0; // tiles processed in memory
+    size_t max_tile  = 0; // triags in the largest of them
+    size_t spilled   = 0; // records written to tile files, halo copies included
+};
+
+
+namespace detail {
+
+struct record_t
+{
+    uint64_t id;
+    double   crds[9];
+
+    max_min_crds_t get_box() const
+    {
+        max_min_crds_t box{};
+        for (int i = 0; i < 9; i += 3) box.update(crds[i], crds[i + 1], crds[i + 2]);
+
+        return box;
+    }
+
+    triangle_t get_triag() const
+    {
+        return {point_t{crds[0], crds[1], crds[2]}, point_t{crds[3], crds[4], crds[5]}, point_t{crds[6], crds[7], crds[8]}};
+    }
+};
+
+/**
+ * \brief reads records of a tile file in blocks of TILE_READ_SIZE and calls func for each
+*/
+template <typename F>
+void for_each_record(const std::filesystem::path &path, F func)
+{
+    std::ifstream in{path, std::ios::binary};
+    if (!in) throw std::runtime_error{"can't open " + path.string()};
+
+    std::vector<record_t> block(TILE_READ_SIZE);
+
+    while (in)
+    {
+        in.read(reinterpret_cast<char*>(block.data()), block.size() * sizeof(record_t));
+
+        size_t num = static_cast<size_t>(in.gcount()) / sizeof(record_t);
+        for (size_t i = 0; i < num; ++i) func(block[i]);
+    }
+
+    if (in.bad()) throw std::runtime_error{"can't read " + path.string()};
+}
+
+/**
+ * \brief a lost record would silently drop its intersections, so tile files that can't be written stop the search
+*/
+inline std::unique_ptr<std::ofstream> open_tile(const std::filesystem::path &path)
+{
+    auto out = std::make_unique<std::ofstream>(path, std::ios::binary);
+    if (!*out) throw std::runtime_error{"can't create " + path.string()};
+
+    return out;
+}
+
+inline void close_tile(std::ofstream &out, const std::filesystem::path &path)
+{
+    out.close();
+    if (!out) throw std::runtime_error{"can't write " + path.string()};
+}
+
+}
+
+
+/**
+ * \brief out-of-core collision search. The first pass copies the input into a binary tile file and finds the scene box.
+ *        A tile whose triags do not fit into the memory budget is split into k^3 subtiles, a triag is written
+ *        to every subtile its box overlaps (halo copies), so every intersecting pair meets in some tile.
+ *        Tiles that fit are loaded one at a time, the chosen engine marks their triags and flags are merged by id.
+*/
+class tile_processor_t
+{
+    collisions::engine_type     engine_;
+    collisions::engine_params_t engine_params_;
+    stream_params_t             params_;
+
+    std::filesystem::path dir_;
+    size_t                file_num_ = 0;
+
+    std::vector<bool> answer_;
+    stream_stats_t    stats_;
+
+/*==========================================================================*/
+
+    std::filesystem::path new_file() { return dir_ / ("tile_" + std::to_string(file_num_++) + ".bin"); }
+
+    void make_dir()
+    {
+        std::error_code error;
+        if (!std::filesystem::is_directory(params_.tmp_dir, error))
+            throw std::runtime_error{"temporary directory " + params_.tmp_dir + " does not exist"};
+
+        for (size_t i = 0;; ++i)
+        {
+            dir_ = std::filesystem::path{params_.tmp_dir} / ("triag_tiles_" + std::to_string(i));
+            if (std::filesystem::create_directory(dir_)) return;
+        }
+    }
+
+    /**
+     * \brief copies the text input into a tile file, returns the number of triags.
+     *        Throws std::runtime_error if the input ends or breaks before all triags are read
+    */
+    size_t read_input(std::istream &in, const std::filesystem::path &path, max_min_crds_t &box)
+    {
+        long long triag_num = 0;
+        in >> triag_num;
+        if (triag_num <= 0) return 0;
+
+        auto out = detail::open_tile(path);
+
+        detail::record_t record;
+        for (long long i = 0; i < triag_num; ++i)
+        {
+            record.id = static_cast<uint64_t>(i);
+            for (double &crd : record.crds) in >> crd;
+
+            if (!in) throw std::runtime_error{"expected " + std::to_string(triag_num) + " triangles"};
+
+            box.merge(record.get_box());
+            out->write(reinterpret_cast<const char*>(&record), sizeof(record));
+        }
+
+        detail::close_tile(*out, path);
+
+        return static_cast<size_t>(triag_num);
+    }
+
+    /**
+     * \brief loads the tile, runs the engine on it and marks the global ids of the colliding triags
+    */
+    void run_tile(const std::filesystem::path &path, size_t triag_num)
+    {
+        octrees::triag_vector triags;
+        std::vector<uint64_t> ids;
+
+        triags.reserve(triag_num);
+        ids.reserve(triag_num);
+
+        detail::for_each_record(path, [&] (const detail::record_t &record) {
+            triags.push_back({record.get_triag(), triags.size()});
+            ids.push_back(record.id);
+        });
+
+        std::filesystem::remove(path);
+
+        std::vector<bool> tile_answer(triags.size(), false);
+        collisions::find_collisions(engine_, triags, tile_answer, engine_params_);
+
+        for (size_t i = 0, num = ids.size(); i < num; ++i)
+            if (tile_answer[i]) answer_[ids[i]] = true;
+
+        ++stats_.tile_num;
+        stats_.max_tile = std::max(stats_.max_tile, triags.size());
+    }
+
+    /**
+     * \brief the quotient is clamped before the cast: a long triag in a small tile gives one far out of the int range
+    */
+    static int get_cell(double crd, double lo, double size, int cell_num)
+    {
+        if (!(size > 0)) return 0;
+
+        double cell = std::floor((crd - lo) / size);
+        if (!(cell > 0)) return 0;
+
+        return static_cast<int>(std::min(cell, static_cast<double>(cell_num - 1)));
+    }
+
+    void process(const std::filesystem::path &path, const max_min_crds_t &box, size_t triag_num, int depth)
+    {
+        size_t tile_bytes = triag_num * TILE_BYTES_PER_TRIAG;
+
+        if (tile_bytes <= params_.memory_budget || depth >= MAX_TILE_DEPTH) { run_tile(path, triag_num); return; }
+
+        double ratio = static_cast<double>(tile_bytes) / std::max<size_t>(params_.memory_budget, 1);
+        int k = std::min(std::max(static_cast<int>(std::ceil(std::cbrt(ratio))), 2), MAX_TILE_SPLIT);
+
+        std::array<double, 3> lo, size;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            lo[axis]   = box.get_min(axis);
+            size[axis] = (box.get_max(axis) - lo[axis]) / k;
+        }
+
+        size_t tile_num = static_cast<size_t>(k) * k * k;
+
+        std::vector<std::filesystem::path>          paths(tile_num);
+        std::vector<std::unique_ptr<std::ofstream>> files(tile_num);
+        std::vector<size_t>                         counts(tile_num, 0);
+
+        detail::for_each_record(path, [&] (const detail::record_t &record) {
+            max_min_crds_t triag_box = record.get_box();
+
+            std::array<int, 3> lo_cell, hi_cell;
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                lo_cell[axis] = get_cell(triag_box.get_min(axis) - ACCURACY, lo[axis], size[axis], k);
+                hi_cell[axis] = get_cell(triag_box.get_max(axis) + ACCURACY, lo[axis], size[axis], k);
+            }
+
+            for (int x = lo_cell[0]; x <= hi_cell[0]; ++x)
+                for (int y = lo_cell[1]; y <= hi_cell[1]; ++y)
+                    for (int z = lo_cell[2]; z <= hi_cell[2]; ++z)
+                    {
+                        size_t tile = (static_cast<size_t>(x) * k + y) * k + z;
+
+                        if (!files[tile])
+                        {
+                            paths[tile] = new_file();
+                            files[tile] = detail::open_tile(paths[tile]);
+                        }
+
+                        files[tile]->write(reinterpret_cast<const char*>(&record), sizeof(record));
+                        ++counts[tile];
+                    }
+        });
+
+        for (size_t tile = 0; tile < tile_num; ++tile)
+            if (files[tile]) detail::close_tile(*files[tile], paths[tile]);
+
+        files.clear();
+
+        size_t max_count = 0, copy_num = 0, nonempty = 0;
+        for (size_t count : counts)
+        {
+            max_count = std::max(max_count, count);
+            copy_num += count;
+            nonempty += (count > 0);
+        }
+
+        /* triags that cover most of the tile can not be separated by splitting, the tile is processed over the budget */
+        if ((max_count == triag_num && nonempty > 1) || copy_num > MAX_HALO_FACTOR * triag_num)
+        {
+            for (auto &tile_path : paths)
+                if (!tile_path.empty()) std::filesystem::remove(tile_path);
+
+            run_tile(path, triag_num);
+            return;
+        }
+
+        std::filesystem::remove(path);
+
+        for (size_t tile = 0; tile < tile_num; ++tile)
+        {
+            if (counts[tile] == 0) continue;
+
+            stats_.spilled += counts[tile];
+
+            int x = static_cast<int>(tile / (k * k)), y = static_cast<int>(tile / k % k), z = static_cast<int>(tile % k);
+
+            max_min_crds_t tile_box{};
+            tile_box.update(lo[0] + x * size[0], lo[1] + y * size[1], lo[2] + z * size[2]);
+            tile_box.update(lo[0] + (x + 1) * size[0], lo[1] + (y + 1) * size[1], lo[2] + (z + 1) * size[2]);
+
+            process(paths[tile], tile_box, counts[tile], depth + 1);
+        }
+    }
+
+/*==========================================================================*/
+
+    public:
+
+    tile_processor_t(collisions::engine_type engine, const collisions::engine_params_t &engine_params, const stream_params_t &params) :
+    engine_(engine), engine_params_(engine_params), params_(params) {}
+
+    /**
+     * \brief reads "n x1 y1 z1 ... z3 ..." from in, answer is resized to n and marked for every colliding triag.
+     *        Throws std::runtime_error if tmp_dir is missing or a tile file can't be written or read back
+    */
+    stream_stats_t find_collisions(std::istream &in, std::vector<bool> &answer)
+    {
+        stats_ = stream_stats_t{};
+        make_dir();
+
+        max_min_crds_t box{};
+        std::filesystem::path path = new_file();
+
+        try
+        {
+            stats_.triag_num = read_input(in, path, box);
+            stats_.spilled   = stats_.triag_num;
+
+            answer_.assign(stats_.triag_num, false);
+
+            if (stats_.triag_num > 0) process(path, box, stats_.triag_num, 0);
+        }
+        catch (...)
+        {
+            std::error_code error;
+            std::filesystem::remove_all(dir_, error);
+            throw;
+        }
+
+        std::filesystem::remove_all(dir_);
+
+        answer.swap(answer_);
+        return stats_;
+    }
+};
+
+}
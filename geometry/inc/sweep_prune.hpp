@@ -0,0 +1,143 @@
+#pragma once
+#include "double_operations.hpp"
+#include "octree.hpp"
+#include "task_pool.hpp"
+#include <algorithm>
+#include <vector>
+
+
+namespace sweeps {
+
+const size_t SWEEP_TASK_SIZE = (1 << 10); // triags swept by one task in parallel get_collisions()
+
+/**
+ * \brief sort-and-sweep broad phase: triags are sorted by the lower bound of their boxes along the axis
+ *        with the largest spread of box centers, every triag is tested only with the following triags
+ *        whose lower bound does not exceed its upper bound
+*/
+class sap_t
+{
+    octrees::triag_vector                triags_;
+    std::vector<octrees::max_min_crds_t> boxes_;
+
+    /* bounds of boxes_ along axis_, kept apart so the sweep reads them sequentially */
+    std::vector<double> lo_, hi_;
+
+    int axis_ = 0;
+
+/*==========================================================================*/
+
+    int choose_axis() const
+    {
+        double sum[3] = {}, sum_sq[3] = {};
+
+        for (auto &box : boxes_)
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                double center = (box.get_min(axis) + box.get_max(axis)) / 2;
+                sum[axis]    += center;
+                sum_sq[axis] += center * center;
+            }
+
+        int best = 0;
+        double best_var = -1;
+
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            double num = static_cast<double>(boxes_.size());
+            double var = sum_sq[axis] / num - (sum[axis] / num) * (sum[axis] / num);
+
+            if (var > best_var) { best_var = var; best = axis; }
+        }
+
+        return best;
+    }
+
+    template <typename answer_t>
+    void sweep(size_t begin, size_t end, answer_t &answer) const
+    {
+        for (size_t i = begin; i < end; ++i) {
+            const octrees::triag_id_t &it = triags_[i];
+
+            for (size_t j = i + 1, num = triags_.size(); j < num && lo_[j] <= hi_[i] + ACCURACY; ++j) {
+                if (!boxes_[i].overlaps(boxes_[j], ACCURACY)) continue;
+
+                const octrees::triag_id_t &jt = triags_[j];
+
+                octrees::test_pair(it, jt, answer);
+            }
+        }
+    }
+
+/*==========================================================================*/
+
+    public:
+
+    sap_t(octrees::triag_vector triags) : triags_(std::move(triags))
+    {
+        size_t triag_num = triags_.size();
+        if (triag_num == 0) return;
+
+        boxes_.resize(triag_num);
+        for (size_t i = 0; i < triag_num; ++i) boxes_[i].update(triags_[i].triag);
+
+        axis_ = choose_axis();
+
+        std::vector<octrees::index_t> order(triag_num);
+        for (size_t i = 0; i < triag_num; ++i) order[i] = static_cast<octrees::index_t>(i);
+
+        std::stable_sort(order.begin(), order.end(), [this] (octrees::index_t a, octrees::index_t b) {
+            return boxes_[a].get_min(axis_) < boxes_[b].get_min(axis_);
+        });
+
+        std::vector<octrees::index_t> order_copy{order};
+        octrees::apply_permutation(triags_, order);
+        octrees::apply_permutation(boxes_, order_copy);
+
+        lo_.resize(triag_num);
+        hi_.resize(triag_num);
+
+        for (size_t i = 0; i < triag_num; ++i)
+        {
+            lo_[i] = boxes_[i].get_min(axis_);
+            hi_[i] = boxes_[i].get_max(axis_);
+        }
+    }
+
+    int get_axis() const { return axis_; }
+
+    /**
+     * \brief flag mode, answer_t is std::vector<bool> or stats_answer_t
+    */
+    template <typename answer_t>
+    void get_collisions(answer_t &answer) const { sweep(0, triags_.size(), answer); }
+
+    /**
+     * \brief appends every intersecting pair of ids, pairs are sorted and unique
+    */
+    void get_collisions(octrees::pair_vector &pairs) const { sweep(0, triags_.size(), pairs); octrees::sort_pairs(pairs); }
+
+    /**
+     * \brief the sweep is split into chunks of SWEEP_TASK_SIZE triags, every worker fills its own copy of answer
+    */
+    template <typename answer_t>
+    void get_collisions(answer_t &answer, size_t thread_num) const
+    {
+        if (thread_num <= 1) { get_collisions(answer); return; }
+
+        tasks::task_pool_t pool{thread_num};
+
+        std::vector<answer_t> answers = octrees::make_answers(answer, pool.thread_num());
+
+        size_t triag_num = triags_.size();
+        size_t chunk_num = (triag_num + SWEEP_TASK_SIZE - 1) / SWEEP_TASK_SIZE;
+
+        tasks::run_chunks(&pool, chunk_num, [this, triag_num, &pool, &answers] (size_t c) {
+            sweep(c * SWEEP_TASK_SIZE, std::min((c + 1) * SWEEP_TASK_SIZE, triag_num), answers[pool.worker_id()]);
+        });
+
+        octrees::merge_answers(answers, answer);
+    }
+};
+
+}
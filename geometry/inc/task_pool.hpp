@@ -0,0 +1,215 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace tasks {
+
+/**
+ * \brief counter of unfinished tasks, task_pool_t::wait() returns when it drops to zero
+*/
+class task_group_t
+{
+    std::atomic<size_t> pending_{0};
+
+    friend class task_pool_t;
+
+    public:
+
+    bool is_done() const { return pending_.load(std::memory_order_acquire) == 0; }
+};
+
+
+/**
+ * \brief fork-join pool with per-worker deques: owner pops from the back, idle workers steal from the front.
+ *        The thread that constructs the pool is worker 0 and executes tasks while it waits.
+*/
+class task_pool_t
+{
+    using task_t = std::function<void()>;
+
+    struct queued_task_t
+    {
+        task_t        task;
+        task_group_t *group = nullptr;
+    };
+
+    struct worker_queue_t
+    {
+        std::mutex                mtx_;
+        std::deque<queued_task_t> tasks_;
+    };
+
+    std::vector<std::unique_ptr<worker_queue_t>> queues_;
+    std::vector<std::thread>                     workers_;
+
+    std::mutex              sleep_mtx_;
+    std::condition_variable sleep_cv_;
+    std::atomic<size_t>     queued_{0};
+    bool                    stop_ = false;
+
+    task_pool_t *prev_pool_ = nullptr;
+    size_t       prev_id_   = 0;
+
+    static inline thread_local task_pool_t *current_pool_ = nullptr;
+    static inline thread_local size_t       current_id_   = 0;
+
+/*==========================================================================*/
+
+    bool pop_own(size_t id, queued_task_t &item)
+    {
+        worker_queue_t &queue = *queues_[id];
+        std::lock_guard<std::mutex> lock{queue.mtx_};
+
+        if (queue.tasks_.empty()) return false;
+
+        item = std::move(queue.tasks_.back());
+        queue.tasks_.pop_back();
+        return true;
+    }
+
+    bool steal(size_t id, queued_task_t &item)
+    {
+        for (size_t i = 1, num = queues_.size(); i < num; ++i)
+        {
+            worker_queue_t &queue = *queues_[(id + i) % num];
+            std::lock_guard<std::mutex> lock{queue.mtx_};
+
+            if (queue.tasks_.empty()) continue;
+
+            item = std::move(queue.tasks_.front());
+            queue.tasks_.pop_front();
+            return true;
+        }
+        return false;
+    }
+
+    bool run_one(size_t id)
+    {
+        queued_task_t item;
+        if (!pop_own(id, item) && !steal(id, item)) return false;
+
+        queued_.fetch_sub(1, std::memory_order_relaxed);
+
+        item.task();
+        item.group->pending_.fetch_sub(1, std::memory_order_acq_rel);
+        return true;
+    }
+
+    void worker_loop(size_t id)
+    {
+        current_pool_ = this;
+        current_id_   = id;
+
+        for (;;)
+        {
+            if (run_one(id)) continue;
+
+            std::unique_lock<std::mutex> lock{sleep_mtx_};
+            sleep_cv_.wait(lock, [this] { return stop_ || queued_.load() > 0; });
+
+            if (stop_ && queued_.load() == 0) return;
+        }
+    }
+
+/*==========================================================================*/
+
+    public:
+
+    explicit task_pool_t(size_t thread_num = std::thread::hardware_concurrency())
+    {
+        if (thread_num == 0) thread_num = 1;
+
+        for (size_t i = 0; i < thread_num; ++i)
+            queues_.push_back(std::make_unique<worker_queue_t>());
+
+        prev_pool_ = current_pool_;
+        prev_id_   = current_id_;
+
+        current_pool_ = this;
+        current_id_   = 0;
+
+        for (size_t i = 1; i < thread_num; ++i)
+            workers_.emplace_back(&task_pool_t::worker_loop, this, i);
+    }
+
+    task_pool_t(const task_pool_t&) = delete;
+    task_pool_t& operator=(const task_pool_t&) = delete;
+
+    ~task_pool_t()
+    {
+        {
+            std::lock_guard<std::mutex> lock{sleep_mtx_};
+            stop_ = true;
+        }
+        sleep_cv_.notify_all();
+
+        for (auto &worker : workers_) worker.join();
+
+        current_pool_ = prev_pool_;
+        current_id_   = prev_id_;
+    }
+
+    size_t thread_num() const { return queues_.size(); }
+
+    /**
+     * \brief index of the calling worker in [0, thread_num()), use it to pick per-thread storage
+    */
+    size_t worker_id() const { return (current_pool_ == this) ? current_id_ : 0; }
+
+    void spawn(task_group_t &group, task_t task)
+    {
+        group.pending_.fetch_add(1, std::memory_order_relaxed);
+
+        {
+            worker_queue_t &queue = *queues_[worker_id()];
+            std::lock_guard<std::mutex> lock{queue.mtx_};
+            queue.tasks_.push_back({std::move(task), &group});
+        }
+
+        queued_.fetch_add(1, std::memory_order_release);
+
+        if (workers_.empty()) return;
+
+        { std::lock_guard<std::mutex> lock{sleep_mtx_}; }
+        sleep_cv_.notify_one();
+    }
+
+    /**
+     * \brief runs queued tasks on the calling thread until every task of the group is finished
+    */
+    void wait(task_group_t &group)
+    {
+        size_t id = worker_id();
+
+        while (!group.is_done())
+            if (!run_one(id)) std::this_thread::yield();
+    }
+};
+
+
+/**
+ * \brief calls func(c) for every c in [0, chunk_num), in parallel if pool is given
+*/
+template <typename F>
+void run_chunks(task_pool_t *pool, size_t chunk_num, F func)
+{
+    if (!pool || chunk_num < 2)
+    {
+        for (size_t c = 0; c < chunk_num; ++c) func(c);
+        return;
+    }
+
+    task_group_t group;
+    for (size_t c = 0; c < chunk_num; ++c) pool->spawn(group, [c, &func] { func(c); });
+    pool->wait(group);
+}
+
+}
@@ -2,6 +2,7 @@
 
 #include "segment.hpp"
 #include "plane.hpp"
+#include "ray.hpp"
 
 
 namespace geometry {
@@ -15,60 +16,96 @@ enum triag_type
     POINT
 };
 
-class triangle_t
+template <typename real_t>
+class basic_triangle_t
 {
-    point_t   A_, B_, C_;
+    using point_type   = basic_point_t<real_t>;
+    using vector_type  = basic_vector_t<real_t>;
+    using line_type    = basic_line_t<real_t>;
+    using plane_type   = basic_plane_t<real_t>;
+    using segment_type = basic_segment_t<real_t>;
+    using ray_type     = basic_ray_t<real_t>;
+
+    point_type A_, B_, C_;
     triag_type type_;
 
-    plane_t pln_{(vector_t{B_} - vector_t{A_}).vec_product(vector_t{C_} - vector_t{A_}).normalized(), A_};
+    plane_type pln_{(vector_type{B_} - vector_type{A_}).vec_product(vector_type{C_} - vector_type{A_}).normalized(), A_};
 
-    vector_t center_x3_;
-    double bounding_rad_sq_ = NAN;
+    vector_type center_x3_;
+    real_t bounding_rad_sq_ = NAN;
 
 
-    bool is_in_triag(const point_t &pnt) const;
+    bool is_in_triag(const point_type &pnt) const;
 
-    bool check_triags_in_intersect_planes(const triangle_t &triag2) const;
+    bool check_triags_in_intersect_planes(const basic_triangle_t &triag2) const;
 
-    bool check_triags_in_same_plane(const triangle_t &triag2) const;
+    bool check_triags_in_same_plane(const basic_triangle_t &triag2) const;
 
-    segment_t get_triag_intersection(const line_t &line) const;
+    segment_type get_triag_intersection(const line_type &line) const;
 
-    segment_t get_triag_seg() const;
+    segment_type get_triag_seg() const;
 
-    vector_t get_center_vec_x3() const;
+    vector_type get_center_vec_x3() const;
 
     triag_type get_triag_type() const;
 
 
-    bool intersects_triag_triag     (const triangle_t &triag2) const;
-    bool intersects_triag_segment   (const triangle_t &triag2) const;
-    bool intersects_triag_point     (const triangle_t &triag2) const;
+    bool intersects_triag_triag     (const basic_triangle_t &triag2) const;
+    bool intersects_triag_segment   (const basic_triangle_t &triag2) const;
+    bool intersects_triag_point     (const basic_triangle_t &triag2) const;
 
-    bool intersects_segment_segment (const triangle_t &triag2) const;
-    bool intersects_segment_point   (const triangle_t &triag2) const;
-    bool intersects_point_point     (const triangle_t &triag2) const;
+    bool intersects_segment_segment (const basic_triangle_t &triag2) const;
+    bool intersects_segment_point   (const basic_triangle_t &triag2) const;
+    bool intersects_point_point     (const basic_triangle_t &triag2) const;
 
-    bool check_triag_intersect_plane(const triangle_t &triag2) const;
+    bool check_triag_intersect_plane(const basic_triangle_t &triag2) const;
 
 
     public:
 
-    triangle_t(const point_t &A, const point_t &B, const point_t &C);
+    basic_triangle_t(const point_type &A, const point_type &B, const point_type &C);
 
-    segment_t get_segment() const;
+    segment_type get_segment() const;
 
     bool is_valid() const { return (A_.is_valid() && B_.is_valid() && C_.is_valid()); }
 
-    bool intersects(const triangle_t &triag2) const;
+    bool intersects(const basic_triangle_t &triag2) const;
+
+    /**
+     * \brief intersects() built on predicates::orient3d() and orient2d(): no ACCURACY tolerance,
+     *        touching counts as intersecting and the answer is exact at any coordinate scale
+    */
+    bool intersects_exact(const basic_triangle_t &triag2) const;
+
+    /**
+     * \brief bounding spheres check that intersects() starts with, false means the triags are too far to intersect
+    */
+    bool spheres_overlap(const basic_triangle_t &triag2) const;
+
+    /**
+     * \brief Moller-Trumbore test, returns t of the hit point ray.get_point(t) or NAN if the ray misses.
+     *        Degenerate triags and rays lying in the plane of the triag are never hit.
+    */
+    real_t intersect_ray(const ray_type &ray) const;
+
+    triag_type get_type() const { return type_; }
 
     void print() const;
 
-    point_t getA() const { return A_; }
-    point_t getB() const { return B_; }
-    point_t getC() const { return C_; }
+    point_type getA() const { return A_; }
+    point_type getB() const { return B_; }
+    point_type getC() const { return C_; }
 
-    plane_t get_plane() const { return pln_; }
+    plane_type get_plane() const { return pln_; }
+
+    vector_type get_center_x3() const { return center_x3_; }
+
+    real_t get_bounding_rad_sq() const { return bounding_rad_sq_; }
 };
 
+using triangle_t = basic_triangle_t<double>;
+
+extern template class basic_triangle_t<double>;
+extern template class basic_triangle_t<float>;
+
 }
@@ -6,39 +6,101 @@
 
 namespace geometry {
 
-class vector_t
+/**
+ * \brief header-only and constexpr, so the products inline into the octree loops and the narrow phase.
+ *        The ASSERT checks are compiled out with RELEASE
+*/
+template <typename real_t>
+class basic_vector_t
 {
-    double x_, y_, z_;
+    real_t x_, y_, z_;
 
     public:
 
-    vector_t(double x = NAN, double y = NAN, double z = NAN) : x_(x), y_(y), z_(z) {}
-    vector_t(const point_t  &pnt) : x_(pnt.get_x()), y_(pnt.get_y()), z_(pnt.get_z()) {}
+    using value_type = real_t;
 
-    bool is_valid() const { return (std::isfinite(x_) && std::isfinite(y_) && std::isfinite(z_)); }
+    constexpr basic_vector_t(real_t x = NAN, real_t y = NAN, real_t z = NAN) : x_(x), y_(y), z_(z) {}
+    constexpr basic_vector_t(const basic_point_t<real_t> &pnt) : x_(pnt.get_x()), y_(pnt.get_y()), z_(pnt.get_z()) {}
 
+    constexpr bool is_valid() const { return is_finite(x_) && is_finite(y_) && is_finite(z_); }
 
-    bool operator== (const vector_t &vec2) const;
-    bool operator!= (const vector_t &vec2) const;
 
-    vector_t operator- (const vector_t &vec2) const;
-    vector_t operator+ (const vector_t &vec2) const;
+    constexpr bool operator== (const basic_vector_t &vec2) const
+    {
+        ASSERT(is_valid());
+        ASSERT(vec2.is_valid());
 
-    vector_t vec_product(const vector_t &vec2) const;
+        return (is_equal(x_, vec2.x_) && is_equal(y_, vec2.y_) && is_equal(z_, vec2.z_));
+    }
 
-    double sqal_product(const vector_t &vec2) const;
-    double get_squared_len() const;
+    constexpr bool operator!= (const basic_vector_t &vec2) const { return !(*this == vec2); }
 
-    vector_t normalized() const;
-    vector_t negative() const { return {-x_, -y_, -z_}; }
+    constexpr basic_vector_t operator- (const basic_vector_t &vec2) const
+    {
+        ASSERT(is_valid());
+        ASSERT(vec2.is_valid());
+
+        return basic_vector_t{x_ - vec2.x_, y_ - vec2.y_, z_ - vec2.z_};
+    }
+
+    constexpr basic_vector_t operator+ (const basic_vector_t &vec2) const
+    {
+        ASSERT(is_valid());
+        ASSERT(vec2.is_valid());
+
+        return basic_vector_t{x_ + vec2.x_, y_ + vec2.y_, z_ + vec2.z_};
+    }
+
+    constexpr basic_vector_t vec_product(const basic_vector_t &vec2) const
+    {
+        ASSERT(is_valid());
+        ASSERT(vec2.is_valid());
+
+        return basic_vector_t{y_ * vec2.z_ - z_ * vec2.y_,
+                              z_ * vec2.x_ - x_ * vec2.z_,
+                              x_ * vec2.y_ - y_ * vec2.x_};
+    }
+
+    constexpr real_t sqal_product(const basic_vector_t &vec2) const
+    {
+        ASSERT(is_valid());
+        ASSERT(vec2.is_valid());
+
+        return x_*vec2.x_ + y_*vec2.y_ + z_*vec2.z_;
+    }
+
+    constexpr real_t get_squared_len() const
+    {
+        ASSERT(is_valid());
+
+        return x_*x_ + y_*y_ + z_*z_;
+    }
+
+    basic_vector_t normalized() const
+    {
+        ASSERT(is_valid());
+
+        real_t len = std::sqrt(get_squared_len());
+        if (is_equal(len, 0))
+            return *this;
+
+        return basic_vector_t{x_/len, y_/len, z_/len};
+    }
+
+    constexpr basic_vector_t negative() const { return {-x_, -y_, -z_}; }
 
     void   print() const { std::cout << "(" << x_ << ", " << y_ << ", " << z_ << ")" << std::endl; }
-    double get_x() const { return x_; }
-    double get_y() const { return y_; }
-    double get_z() const { return z_; }
+    constexpr real_t get_x() const { return x_; }
+    constexpr real_t get_y() const { return y_; }
+    constexpr real_t get_z() const { return z_; }
 };
 
-const vector_t NULL_VEC = vector_t{0, 0, 0};
-const vector_t NAN_VEC  = vector_t{NAN, NAN, NAN};
+using vector_t = basic_vector_t<double>;
+
+template <typename real_t> constexpr basic_vector_t<real_t> null_vec = {0, 0, 0};
+template <typename real_t> constexpr basic_vector_t<real_t> nan_vec  = {NAN, NAN, NAN};
+
+constexpr vector_t NULL_VEC = null_vec<double>;
+constexpr vector_t NAN_VEC  = nan_vec<double>;
 
 }
@@ -7,9 +7,10 @@ using namespace geometry;
 using namespace doperations;
 
 
-bool segment_t::contains_inter_pnt(const point_t &pnt) const
+template <typename real_t>
+bool basic_segment_t<real_t>::contains_inter_pnt(const point_type &pnt) const
 {
-    double x_min = std::min(first_.get_x(), second_.get_x()),
+    real_t x_min = std::min(first_.get_x(), second_.get_x()),
            x_max = std::max(first_.get_x(), second_.get_x()),
            y_min = std::min(first_.get_y(), second_.get_y()),
            y_max = std::max(first_.get_y(), second_.get_y()),
@@ -22,12 +23,10 @@ bool segment_t::contains_inter_pnt(const point_t &pnt) const
 }
 
 
-bool segment_t::intersects_seg(const segment_t &seg2) const
+template <typename real_t>
+bool basic_segment_t<real_t>::intersects_seg(const basic_segment_t &seg2) const
 {
-    line_t seg_line1{vector_t{second_} - vector_t{first_}, first_};
-    line_t seg_line2{vector_t{seg2.second_} - vector_t{seg2.first_}, seg2.first_};
-
-    point_t intersection_pnt{seg_line1.get_line_intersection(seg_line2)};
+    point_type intersection_pnt{seg_line_.get_line_intersection(seg2.seg_line_)};
 
     if (intersection_pnt.special_check())
     {
@@ -40,44 +39,49 @@ bool segment_t::intersects_seg(const segment_t &seg2) const
 }
 
 
-point_t segment_t::get_line_intersection(const line_t &line) const
+template <typename real_t>
+basic_point_t<real_t> basic_segment_t<real_t>::get_line_intersection(const line_type &line) const
 {
-    if ((dir_vec_.vec_product(line.get_dir_vec()) == NULL_VEC) && !(line.check_point_belong(first_)))
-        return NAN_PNT;
-
-    if ((dir_vec_.vec_product(line.get_dir_vec()) == NULL_VEC) && (line.check_point_belong(first_)))
-        return SPEC_PNT;
+    if (dir_vec_.vec_product(line.get_dir_vec()) == null_vec<real_t>)
+        return line.check_point_belong(first_) ? spec_pnt<real_t> : nan_pnt<real_t>;
 
-    point_t intersection_pnt{seg_line_.get_line_intersection(line)};
+    point_type intersection_pnt{seg_line_.get_line_intersection(line)};
 
     if (contains_inter_pnt(intersection_pnt)) return intersection_pnt;
-    return NAN_PNT;
+    return nan_pnt<real_t>;
 }
 
 
-bool segment_t::contains_inter_seg(const segment_t &seg2) const
+template <typename real_t>
+bool basic_segment_t<real_t>::contains_inter_seg(const basic_segment_t &seg2) const
 {
     return contains_inter_pnt(seg2.first_) || contains_inter_pnt(seg2.second_) ||
            seg2.contains_inter_pnt(first_) || seg2.contains_inter_pnt(second_);
 }
 
 
-point_t segment_t::get_plane_intersection(const plane_t &pln) const
+template <typename real_t>
+basic_point_t<real_t> basic_segment_t<real_t>::get_plane_intersection(const plane_type &pln) const
 {
     ASSERT(is_valid());
     ASSERT(pln.is_valid());
 
-    point_t pnt = pln.get_line_intersection(seg_line_);
+    point_type pnt = pln.get_line_intersection(seg_line_);
     if (!pnt.is_valid()) return pnt;
 
-    if (!contains_inter_pnt(pnt)) return NAN_PNT;
+    if (!contains_inter_pnt(pnt)) return nan_pnt<real_t>;
     return pnt;
 }
 
 
-void segment_t::print() const
+template <typename real_t>
+void basic_segment_t<real_t>::print() const
 {
     std::cout << "segment:\n";
     first_.print();
     second_.print();
 }
+
+
+template class geometry::basic_segment_t<double>;
+template class geometry::basic_segment_t<float>;
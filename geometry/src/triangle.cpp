@@ -2,41 +2,44 @@
 #include "custom_assert.hpp"
 #include "triangle.hpp"
 #include "point.hpp"
+#include "exact_intersection.hpp"
 #include <iostream>
-#include <vector>
 
 using namespace geometry;
 using namespace doperations;
 
 
-triangle_t::triangle_t(const point_t &A, const point_t &B, const point_t &C) : A_(A), B_(B), C_(C), type_(get_triag_type())
+template <typename real_t>
+basic_triangle_t<real_t>::basic_triangle_t(const point_type &A, const point_type &B, const point_type &C) : A_(A), B_(B), C_(C), type_(get_triag_type())
 {
     type_ = get_triag_type();
-    center_x3_ = vector_t{A_} + vector_t{B_} + vector_t{C_};
+    center_x3_ = vector_type{A_} + vector_type{B_} + vector_type{C_};
 
-    double lenab = (vector_t{B_} - vector_t{A_}).get_squared_len();
-    double lenbc = (vector_t{C_} - vector_t{B_}).get_squared_len();
-    double lenca = (vector_t{A_} - vector_t{C_}).get_squared_len();
+    real_t lenab = (vector_type{B_} - vector_type{A_}).get_squared_len();
+    real_t lenbc = (vector_type{C_} - vector_type{B_}).get_squared_len();
+    real_t lenca = (vector_type{A_} - vector_type{C_}).get_squared_len();
 
-    double max_sq = triple_max(lenab, lenbc, lenca);
+    real_t max_sq = triple_max(lenab, lenbc, lenca);
 
     bounding_rad_sq_ = max_sq;
 }
 
 
-triag_type triangle_t::get_triag_type() const
+template <typename real_t>
+triag_type basic_triangle_t<real_t>::get_triag_type() const
 {
     ASSERT(is_valid());
 
     if ((A_ == B_) && (B_ == C_)) return POINT;
-    if ((vector_t{B_} - vector_t{A_}).vec_product(vector_t{C_} - vector_t{A_}) == NULL_VEC ||
-        (vector_t{B_} - vector_t{A_}).vec_product(vector_t{C_} - vector_t{B_}) == NULL_VEC ||
-        (vector_t{C_} - vector_t{A_}).vec_product(vector_t{C_} - vector_t{B_}) == NULL_VEC) return SEGMENT;
+    if ((vector_type{B_} - vector_type{A_}).vec_product(vector_type{C_} - vector_type{A_}) == null_vec<real_t> ||
+        (vector_type{B_} - vector_type{A_}).vec_product(vector_type{C_} - vector_type{B_}) == null_vec<real_t> ||
+        (vector_type{C_} - vector_type{A_}).vec_product(vector_type{C_} - vector_type{B_}) == null_vec<real_t>) return SEGMENT;
     return TRIAG;
 }
 
 
-void triangle_t::print() const
+template <typename real_t>
+void basic_triangle_t<real_t>::print() const
 {
     std::cout << "\ntriangle: " << "type " << type_ << std::endl;
     std::cout << "A = ";
@@ -48,13 +51,13 @@ void triangle_t::print() const
 }
 
 
-bool triangle_t::intersects(const triangle_t &triag2) const
+template <typename real_t>
+bool basic_triangle_t<real_t>::intersects(const basic_triangle_t &triag2) const
 {
     ASSERT(is_valid());
     ASSERT(triag2.is_valid());
 
-    double distanced_squared_x9 = (center_x3_ - triag2.center_x3_).get_squared_len();
-    if (distanced_squared_x9 > brad_coeff * (bounding_rad_sq_ + triag2.bounding_rad_sq_)) return false;
+    if (!spheres_overlap(triag2)) return false;
 
 
     switch(type_)
@@ -91,19 +94,61 @@ bool triangle_t::intersects(const triangle_t &triag2) const
 }
 
 
-bool triangle_t::intersects_point_point(const triangle_t &triag2) const
+template <typename real_t>
+bool basic_triangle_t<real_t>::spheres_overlap(const basic_triangle_t &triag2) const
 {
-    point_t pnt1 = {center_x3_.get_x() / 3, center_x3_.get_y() / 3, center_x3_.get_z() / 3};
-    point_t pnt2 = {triag2.center_x3_.get_x() / 3, triag2.center_x3_.get_y() / 3, triag2.center_x3_.get_z() / 3};
+    real_t distanced_squared_x9 = (center_x3_ - triag2.center_x3_).get_squared_len();
+    return !(distanced_squared_x9 > brad_coeff * (bounding_rad_sq_ + triag2.bounding_rad_sq_));
+}
+
+
+template <typename real_t>
+real_t basic_triangle_t<real_t>::intersect_ray(const ray_type &ray) const
+{
+    ASSERT(is_valid());
+    ASSERT(ray.is_valid());
+
+    if (type_ != TRIAG) return NAN;
+
+    vector_type edge1 = vector_type{B_} - vector_type{A_};
+    vector_type edge2 = vector_type{C_} - vector_type{A_};
+
+    vector_type pvec = ray.get_dir().vec_product(edge2);
+    real_t      det  = edge1.sqal_product(pvec);
+
+    if (det == 0) return NAN;
+
+    real_t inv_det = 1 / det;
+
+    vector_type tvec = vector_type{ray.get_origin()} - vector_type{A_};
+    real_t      u    = tvec.sqal_product(pvec) * inv_det;
+    if (!gr_or_eq(u, 0) || !ls_or_eq(u, 1)) return NAN;
+
+    vector_type qvec = tvec.vec_product(edge1);
+    real_t      v    = ray.get_dir().sqal_product(qvec) * inv_det;
+    if (!gr_or_eq(v, 0) || !ls_or_eq(u + v, 1)) return NAN;
+
+    real_t t = edge2.sqal_product(qvec) * inv_det;
+
+    return (t < 0) ? NAN : t;
+}
+
+
+template <typename real_t>
+bool basic_triangle_t<real_t>::intersects_point_point(const basic_triangle_t &triag2) const
+{
+    point_type pnt1 = {center_x3_.get_x() / 3, center_x3_.get_y() / 3, center_x3_.get_z() / 3};
+    point_type pnt2 = {triag2.center_x3_.get_x() / 3, triag2.center_x3_.get_y() / 3, triag2.center_x3_.get_z() / 3};
 
     return (pnt1 == pnt2);
 }
 
 
-bool triangle_t::intersects_segment_point(const triangle_t &triag2) const
+template <typename real_t>
+bool basic_triangle_t<real_t>::intersects_segment_point(const basic_triangle_t &triag2) const
 {
-    segment_t seg1 = get_segment();
-    point_t pnt = {triag2.center_x3_.get_x() / 3, triag2.center_x3_.get_y() / 3, triag2.center_x3_.get_z() / 3};
+    segment_type seg1 = get_segment();
+    point_type pnt = {triag2.center_x3_.get_x() / 3, triag2.center_x3_.get_y() / 3, triag2.center_x3_.get_z() / 3};
 
     if ( !seg1.get_seg_line().check_point_belong(pnt) ) return false;
 
@@ -113,12 +158,13 @@ bool triangle_t::intersects_segment_point(const triangle_t &triag2) const
 }
 
 
-bool triangle_t::intersects_segment_segment(const triangle_t &triag2) const
+template <typename real_t>
+bool basic_triangle_t<real_t>::intersects_segment_segment(const basic_triangle_t &triag2) const
 {
-    segment_t seg1 = get_segment();
-    segment_t seg2 = triag2.get_segment();
+    segment_type seg1 = get_segment();
+    segment_type seg2 = triag2.get_segment();
 
-    point_t pnt = seg1.get_seg_line().get_line_intersection(seg2.get_seg_line());
+    point_type pnt = seg1.get_seg_line().get_line_intersection(seg2.get_seg_line());
 
     if (pnt.special_check())
         return seg1.intersects_seg(seg2);
@@ -129,9 +175,10 @@ bool triangle_t::intersects_segment_segment(const triangle_t &triag2) const
 }
 
 
-bool triangle_t::intersects_triag_point(const triangle_t &triag2) const
+template <typename real_t>
+bool basic_triangle_t<real_t>::intersects_triag_point(const basic_triangle_t &triag2) const
 {
-    point_t pnt = {triag2.center_x3_.get_x() / 3, triag2.center_x3_.get_y() / 3, triag2.center_x3_.get_z() / 3};
+    point_type pnt = {triag2.center_x3_.get_x() / 3, triag2.center_x3_.get_y() / 3, triag2.center_x3_.get_z() / 3};
 
     if (!is_equal(pln_.calc_point(pnt), 0)) return false;
     if (!is_in_triag(pnt)) return false;
@@ -140,11 +187,12 @@ bool triangle_t::intersects_triag_point(const triangle_t &triag2) const
 }
 
 
-bool triangle_t::intersects_triag_segment(const triangle_t &triag2) const
+template <typename real_t>
+bool basic_triangle_t<real_t>::intersects_triag_segment(const basic_triangle_t &triag2) const
 {
-    segment_t seg = triag2.get_segment();
+    segment_type seg = triag2.get_segment();
 
-    point_t pnt = pln_.get_line_intersection(seg.get_seg_line());
+    point_type pnt = pln_.get_line_intersection(seg.get_seg_line());
 
     if ( pnt.special_check() )
     {
@@ -152,7 +200,7 @@ bool triangle_t::intersects_triag_segment(const triangle_t &triag2) const
                     is_in_triag(seg.get_snd());
         if (cond) return true;
 
-        segment_t AB{A_, B_},
+        segment_type AB{A_, B_},
                   BC{B_, C_},
                   CA{C_, A_};
 
@@ -171,26 +219,24 @@ bool triangle_t::intersects_triag_segment(const triangle_t &triag2) const
 }
 
 
-segment_t triangle_t::get_segment() const
+template <typename real_t>
+basic_segment_t<real_t> basic_triangle_t<real_t>::get_segment() const
 {
-    segment_t AB{A_, B_},
-              BC{B_, C_},
-              CA{C_, A_};
-
-    double ab = AB.get_dir_vec().get_squared_len();
-    double bc = BC.get_dir_vec().get_squared_len();
-    double ca = CA.get_dir_vec().get_squared_len();
-    double max = triple_max(ab, bc, ca);
+    real_t ab = (vector_type{B_} - vector_type{A_}).get_squared_len();
+    real_t bc = (vector_type{C_} - vector_type{B_}).get_squared_len();
+    real_t ca = (vector_type{A_} - vector_type{C_}).get_squared_len();
+    real_t max = triple_max(ab, bc, ca);
 
-    if (is_equal(ab, max)) return AB;
-    if (is_equal(bc, max)) return BC;
-    if (is_equal(ca, max)) return CA;
+    if (is_equal(ab, max)) return {A_, B_};
+    if (is_equal(bc, max)) return {B_, C_};
+    if (is_equal(ca, max)) return {C_, A_};
 
-    return {NAN_PNT, NAN_PNT};
+    return {nan_pnt<real_t>, nan_pnt<real_t>};
 }
 
 
-bool triangle_t::intersects_triag_triag(const triangle_t &triag2) const
+template <typename real_t>
+bool basic_triangle_t<real_t>::intersects_triag_triag(const basic_triangle_t &triag2) const
 {
     mutual_pos plane_pos_type = pln_.get_mutual_pos_type(triag2.pln_, A_);
 
@@ -205,7 +251,8 @@ bool triangle_t::intersects_triag_triag(const triangle_t &triag2) const
 }
 
 
-bool triangle_t::check_triags_in_same_plane(const triangle_t &triag2) const
+template <typename real_t>
+bool basic_triangle_t<real_t>::check_triags_in_same_plane(const basic_triangle_t &triag2) const
 {
     bool cond1 = triag2.is_in_triag(A_) ||
                  triag2.is_in_triag(B_) ||
@@ -215,24 +262,26 @@ bool triangle_t::check_triags_in_same_plane(const triangle_t &triag2) const
                  is_in_triag(triag2.C_);
     if (cond1 || cond2) return true;
 
-    std::vector<segment_t> segments{{A_, B_}, {B_, C_}, {C_, A_}, {triag2.A_, triag2.B_}, {triag2.B_, triag2.C_}, {triag2.C_, triag2.A_}};
+    const segment_type sides1[3]{{A_, B_}, {B_, C_}, {C_, A_}};
+    const segment_type sides2[3]{{triag2.A_, triag2.B_}, {triag2.B_, triag2.C_}, {triag2.C_, triag2.A_}};
 
-    for (int i = 0; i < 3; ++i)
-        for (int j = 3; j < 6; ++j)
-                if (segments[i].intersects_seg(segments[j])) return true;
+    for (const segment_type &side1 : sides1)
+        for (const segment_type &side2 : sides2)
+            if (side1.intersects_seg(side2)) return true;
 
     return false;
 }
 
 
-bool triangle_t::check_triags_in_intersect_planes(const triangle_t &triag2) const
+template <typename real_t>
+bool basic_triangle_t<real_t>::check_triags_in_intersect_planes(const basic_triangle_t &triag2) const
 {
     if (!check_triag_intersect_plane(triag2)) return false;
 
-    line_t inter_line{pln_.get_intersection(triag2.pln_)};
+    line_type inter_line{pln_.get_intersection(triag2.pln_)};
     if ( !inter_line.is_valid() ) return false;
 
-    segment_t seg1{get_triag_intersection(inter_line)},
+    segment_type seg1{get_triag_intersection(inter_line)},
               seg2{triag2.get_triag_intersection(inter_line)};
 
     if (!seg1.is_valid() || !seg2.is_valid()) return false;
@@ -241,11 +290,12 @@ bool triangle_t::check_triags_in_intersect_planes(const triangle_t &triag2) cons
 }
 
 
-bool triangle_t::check_triag_intersect_plane(const triangle_t &triag2) const
+template <typename real_t>
+bool basic_triangle_t<real_t>::check_triag_intersect_plane(const basic_triangle_t &triag2) const
 {
-    double res1 = triag2.pln_.calc_point(A_);
-    double res2 = triag2.pln_.calc_point(B_);
-    double res3 = triag2.pln_.calc_point(C_);
+    real_t res1 = triag2.pln_.calc_point(A_);
+    real_t res2 = triag2.pln_.calc_point(B_);
+    real_t res3 = triag2.pln_.calc_point(C_);
     if (all_positive(res1, res2, res3) ||
         all_negative(res1, res2, res3)) return false;
 
@@ -259,19 +309,20 @@ bool triangle_t::check_triag_intersect_plane(const triangle_t &triag2) const
 }
 
 
-bool triangle_t::is_in_triag(const point_t &pnt) const
+template <typename real_t>
+bool basic_triangle_t<real_t>::is_in_triag(const point_type &pnt) const
 {
-    vector_t v1{(vector_t{B_} - vector_t{A_}).vec_product((vector_t{pnt} - vector_t{A_}))};
-    vector_t v2{(vector_t{C_} - vector_t{B_}).vec_product((vector_t{pnt} - vector_t{B_}))};
-    vector_t v3{(vector_t{A_} - vector_t{C_}).vec_product((vector_t{pnt} - vector_t{C_}))};
+    vector_type v1{(vector_type{B_} - vector_type{A_}).vec_product((vector_type{pnt} - vector_type{A_}))};
+    vector_type v2{(vector_type{C_} - vector_type{B_}).vec_product((vector_type{pnt} - vector_type{B_}))};
+    vector_type v3{(vector_type{A_} - vector_type{C_}).vec_product((vector_type{pnt} - vector_type{C_}))};
 
-    vector_t resv1 = vector_t{pnt} + v1;
-    vector_t resv2 = vector_t{pnt} + v2;
-    vector_t resv3 = vector_t{pnt} + v3;
+    vector_type resv1 = vector_type{pnt} + v1;
+    vector_type resv2 = vector_type{pnt} + v2;
+    vector_type resv3 = vector_type{pnt} + v3;
 
-    double res1 = pln_.calc_point({resv1.get_x(), resv1.get_y(), resv1.get_z()});
-    double res2 = pln_.calc_point({resv2.get_x(), resv2.get_y(), resv2.get_z()});
-    double res3 = pln_.calc_point({resv3.get_x(), resv3.get_y(), resv3.get_z()});
+    real_t res1 = pln_.calc_point({resv1.get_x(), resv1.get_y(), resv1.get_z()});
+    real_t res2 = pln_.calc_point({resv2.get_x(), resv2.get_y(), resv2.get_z()});
+    real_t res3 = pln_.calc_point({resv3.get_x(), resv3.get_y(), resv3.get_z()});
 
     if (all_positive_triag_special(res1, res2, res3) || all_negative_triag_special(res1, res2, res3)) return true;
 
@@ -279,40 +330,40 @@ bool triangle_t::is_in_triag(const point_t &pnt) const
 }
 
 
-segment_t triangle_t::get_triag_intersection(const line_t &line) const
+template <typename real_t>
+basic_segment_t<real_t> basic_triangle_t<real_t>::get_triag_intersection(const line_type &line) const
 {
     ASSERT(is_valid());
     ASSERT(line.is_valid());
 
     int valid_cnt = 0;
 
-    segment_t AB{A_, B_},
-              BC{B_, C_},
-              CA{C_, A_};
-
-
-    point_t p1{AB.get_line_intersection(line)};
+    /* every side is built only when the previous ones did not decide */
+    segment_type AB{A_, B_};
+    point_type p1{AB.get_line_intersection(line)};
 
     if (p1.is_valid()) valid_cnt++;
     else if (p1.special_check())
         return AB;
 
 
-    point_t p2{BC.get_line_intersection(line)};
+    segment_type BC{B_, C_};
+    point_type p2{BC.get_line_intersection(line)};
 
     if (p2.is_valid()) valid_cnt++;
     else if (p2.special_check())
         return BC;
 
 
-    point_t p3{CA.get_line_intersection(line)};
+    segment_type CA{C_, A_};
+    point_type p3{CA.get_line_intersection(line)};
 
     if (p3.is_valid()) valid_cnt++;
     else if (p3.special_check())
         return CA;
 
 
-    if (valid_cnt < 2) return {NAN_PNT, NAN_PNT};
+    if (valid_cnt < 2) return {nan_pnt<real_t>, nan_pnt<real_t>};
 
     if (valid_cnt == 2)
     {
@@ -324,3 +375,18 @@ segment_t triangle_t::get_triag_intersection(const line_t &line) const
     if (p1 == p2) return {p1, p3};
     return {p1, p2};
 }
+
+
+template <typename real_t>
+bool basic_triangle_t<real_t>::intersects_exact(const basic_triangle_t &triag2) const
+{
+    ASSERT(is_valid());
+    ASSERT(triag2.is_valid());
+
+    /* float vertices are exactly representable in double, the predicates stay exact */
+    return exact::triags_intersect(point_t{A_}, point_t{B_}, point_t{C_}, point_t{triag2.A_}, point_t{triag2.B_}, point_t{triag2.C_});
+}
+
+
+template class geometry::basic_triangle_t<double>;
+template class geometry::basic_triangle_t<float>;
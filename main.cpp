@@ -2,6 +2,10 @@
 #include "point.hpp"
 #include "vector.hpp"
 #include "octree.hpp"
+#include "collisions.hpp"
+#include "streaming.hpp"
+#include "report.hpp"
+#include "integer_grid.hpp"
 #include "app.hpp"
 #include "model.hpp"
 #include <iostream>
@@ -9,11 +13,179 @@
 #include <array>
 #include "chrono"
 #include <set>
+#include <thread>
+#include <cstring>
+#include <string>
+#include <stdexcept>
 
 using namespace geometry;
 
-int main()
+struct options_t
 {
+    collisions::engine_type   engine = collisions::OCTREE;
+    collisions::engine_params_t params{std::max(1u, std::thread::hardware_concurrency())};
+
+    bool border_stats = false;
+    bool bench        = false;
+    bool pairs        = false;
+    bool stream       = false;
+    bool stats        = false;
+    bool exact        = false;
+    bool integer      = false;
+
+    streaming::stream_params_t stream_params;
+
+    std::string save_index; // octree index file written after the build
+    std::string index;      // octree index file queried instead of reading triags
+};
+
+static bool parse_options(int argc, char **argv, options_t &opts)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        if (!std::strcmp(argv[i], "--threads") && i + 1 < argc)
+        {
+            opts.params.thread_num = std::stoul(argv[++i]);
+            if (opts.params.thread_num == 0) opts.params.thread_num = 1;
+        }
+        else if (!std::strcmp(argv[i], "--loose") && i + 1 < argc)
+            opts.params.loose_factor = std::stod(argv[++i]);
+        else if (!std::strcmp(argv[i], "--leaf-size") && i + 1 < argc)
+        {
+            ++i;
+            opts.params.leaf_size = std::strcmp(argv[i], "auto") ? std::stoul(argv[i]) : octrees::AUTO_LEAF_SIZE;
+        }
+        else if (!std::strcmp(argv[i], "--max-depth") && i + 1 < argc)
+            opts.params.max_depth = std::stoul(argv[++i]);
+        else if (!std::strcmp(argv[i], "--engine") && i + 1 < argc && collisions::get_engine_type(argv[i + 1], opts.engine))
+            ++i;
+        else if (!std::strcmp(argv[i], "--border-stats"))
+            opts.border_stats = true;
+        else if (!std::strcmp(argv[i], "--bench"))
+            opts.bench = true;
+        else if (!std::strcmp(argv[i], "--pairs"))
+            opts.pairs = true;
+        else if (!std::strcmp(argv[i], "--stats"))
+            opts.stats = true;
+        else if (!std::strcmp(argv[i], "--exact"))
+            opts.exact = true;
+        else if (!std::strcmp(argv[i], "--float"))
+            opts.params.float_filter = true;
+        else if (!std::strcmp(argv[i], "--integer"))
+            opts.integer = true;
+        else if (!std::strcmp(argv[i], "--stream"))
+            opts.stream = true;
+        else if (!std::strcmp(argv[i], "--memory-budget") && i + 1 < argc)
+            opts.stream_params.memory_budget = std::stoul(argv[++i]) << 20;
+        else if (!std::strcmp(argv[i], "--tmp-dir") && i + 1 < argc)
+            opts.stream_params.tmp_dir = argv[++i];
+        else if (!std::strcmp(argv[i], "--save-index") && i + 1 < argc)
+            opts.save_index = argv[++i];
+        else if (!std::strcmp(argv[i], "--index") && i + 1 < argc)
+            opts.index = argv[++i];
+        else
+        {
+            std::cerr << "usage: " << argv[0] << " [--engine octree|sap|bvh|grid|linear] [--threads N] [--loose K] [--leaf-size N|auto] [--max-depth D] [--border-stats] [--bench] [--stats] [--exact] [--float] [--integer] [--pairs] [--stream [--memory-budget MB] [--tmp-dir DIR]] [--save-index FILE] [--index FILE]" << std::endl;
+            return false;
+        }
+    }
+
+    if (opts.stream && opts.pairs)
+    {
+        std::cerr << "--pairs is not supported with --stream" << std::endl;
+        return false;
+    }
+
+    if (opts.integer && (opts.stream || !opts.index.empty()))
+    {
+        std::cerr << "--integer can't be combined with --stream or --index" << std::endl;
+        return false;
+    }
+
+    if (opts.exact && (opts.pairs || opts.stream || !opts.index.empty()))
+    {
+        std::cerr << "--exact can't be combined with --pairs, --stream or --index" << std::endl;
+        return false;
+    }
+
+    if (!opts.index.empty() && (opts.stream || !opts.save_index.empty()))
+    {
+        std::cerr << "--index can't be combined with --stream or --save-index" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    options_t opts;
+    if (!parse_options(argc, argv, opts)) return -1;
+
+    if (opts.stream)
+    {
+        std::vector<bool> answer;
+        streaming::stream_stats_t stats;
+
+        try
+        {
+            streaming::tile_processor_t processor{opts.engine, opts.params, opts.stream_params};
+            stats = processor.find_collisions(std::cin, answer);
+        }
+        catch (const std::runtime_error &error)
+        {
+            std::cerr << "--stream: " << error.what() << std::endl;
+            return -1;
+        }
+
+        if (opts.bench)
+            std::cerr << "stream: " << stats.tile_num << " tiles, largest " << stats.max_tile << " triags, "
+                      << stats.spilled << " records spilled" << std::endl;
+
+        for (size_t i = 0, num = answer.size(); i < num; i++)
+            if (answer[i]) std::cout << i << std::endl;
+
+        return 0;
+    }
+
+    if (!opts.index.empty())
+    {
+        try
+        {
+            auto start = std::chrono::steady_clock::now();
+            octrees::octree_t tree = octrees::octree_t::open_index(opts.index, opts.params.float_filter);
+            double open_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            start = std::chrono::steady_clock::now();
+
+            std::vector<bool> answer(tree.triags().size(), false);
+            octrees::pair_vector pairs;
+
+            if (opts.pairs)
+                tree.get_collisions(pairs);
+            else
+                tree.get_collisions(answer, opts.params.thread_num);
+
+            double query_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            if (opts.bench)
+                std::cerr << "index: open " << open_time << " s, query " << query_time << " s" << std::endl;
+
+            if (opts.pairs)
+                for (auto &pair : pairs) std::cout << pair.first << " " << pair.second << std::endl;
+            else
+                for (size_t i = 0, num = answer.size(); i < num; i++)
+                    if (answer[i]) std::cout << i << std::endl;
+        }
+        catch (const std::runtime_error &error)
+        {
+            std::cerr << error.what() << std::endl;
+            return -1;
+        }
+
+        return 0;
+    }
+
     int triag_num = 0;
     if (triag_num < 0)
     {
@@ -21,6 +193,8 @@ int main()
         return -1;
     }
 
+    auto parse_start = std::chrono::steady_clock::now();
+
     std::cin >> triag_num;
     std::vector<octrees::triag_id_t> triags;
 
@@ -42,20 +216,104 @@ int main()
     else
         std::cerr << "Triangle number should be greater than 0" << std::endl;
 
+    double parse_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - parse_start).count();
+
     // const std::clock_t start = clock();
 
-    octrees::octree_t octree(triags);
+    if (opts.stats)
+    {
+        reports::report_t report = reports::collect_report(opts.engine, triags, opts.params);
+        report.parse_time = parse_time;
+
+        reports::print_json(std::cerr, report);
+    }
+
+    if (!opts.save_index.empty())
+    {
+        try
+        {
+            octrees::octree_t{triags, opts.params.octree_params()}.save_index(opts.save_index);
+        }
+        catch (const std::runtime_error &error)
+        {
+            std::cerr << error.what() << std::endl;
+            return -1;
+        }
+    }
+
+    if (opts.border_stats)
+    {
+        octrees::octree_params_t strict_params = opts.params.octree_params();
+        strict_params.loose_factor = 1;
+
+        octrees::octree_t strict{triags, strict_params};
+        octrees::octree_t loose {triags, opts.params.octree_params()};
+
+        std::cerr << "border fraction: strict " << strict.border_fraction() << ", loose(" << opts.params.loose_factor << ") " << loose.border_fraction() << std::endl;
+    }
+
+    std::vector<bool> answer(triag_num, false);
+    octrees::pair_vector pairs;
+
+    int64_t grid_scale = opts.integer ? grids::find_grid_scale(triags) : 0;
+    if (opts.integer && grid_scale == 0)
+    {
+        /* the exact predicates give the answer of the integer path for any coordinates, they only do not support --pairs */
+        std::cerr << "coordinates are not on a decimal grid, --integer " << (opts.pairs ? "is ignored" : "falls back to --exact") << std::endl;
+        opts.exact = !opts.pairs;
+    }
+
+    if (grid_scale)
+    {
+        auto start = std::chrono::steady_clock::now();
+        grids::int_sweep_t sweep{triags, grid_scale};
+
+        if (opts.pairs)
+        {
+            sweep.get_collisions(pairs, opts.params.thread_num);
+            for (auto &pair : pairs) answer[pair.first] = answer[pair.second] = true;
+        }
+        else
+            sweep.get_collisions(answer, opts.params.thread_num);
+
+        if (opts.bench)
+            std::cerr << "integer: grid step 1/" << grid_scale << ", "
+                      << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() << " s" << std::endl;
+    }
+    else if (opts.pairs)
+    {
+        collisions::find_collisions(opts.engine, triags, pairs, opts.params);
+
+        for (auto &pair : pairs) answer[pair.first] = answer[pair.second] = true;
+    }
+    else if (opts.exact)
+    {
+        octrees::exact_answer_t exact_answer{std::vector<bool>(triag_num, false)};
+        collisions::find_collisions(opts.engine, triags, exact_answer, opts.params);
+
+        answer.swap(exact_answer.flags);
+    }
+    else
+        collisions::find_collisions(opts.engine, triags, answer, opts.params);
 
-    std::vector<bool> answer;
-    answer.reserve(triag_num);
+    if (opts.bench)
+    {
+        for (int i = 0; i < collisions::ENGINE_NUM; ++i)
+        {
+            std::vector<bool> bench_answer(triag_num, false);
 
-    for (int i = 0; i < triag_num; i++)
-        answer[i] = false;
+            collisions::phase_times_t times = collisions::find_collisions(static_cast<collisions::engine_type>(i), triags, bench_answer, opts.params);
 
-    octree.get_collisions(answer);
+            std::cerr << collisions::engine_names[i] << ": build " << times.build << " s, query " << times.query << " s"
+                      << ((bench_answer == answer) ? "" : ", answer differs") << std::endl;
+        }
+    }
 
-    for (int i = 0; i < triag_num; i++)
-        if(answer[i]) std::cout << i << std::endl;
+    if (opts.pairs)
+        for (auto &pair : pairs) std::cout << pair.first << " " << pair.second << std::endl;
+    else
+        for (int i = 0; i < triag_num; i++)
+            if(answer[i]) std::cout << i << std::endl;
 
     // std::cout << "Total time is " << (clock() - start) / (double) CLOCKS_PER_SEC << std::endl;
 
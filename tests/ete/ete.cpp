@@ -1,86 +1,72 @@
-#include <ctime>
-#include <vector>
 #include <fstream>
-#include <set>
+#include <iostream>
+#include <iterator>
+#include <vector>
 
 #include "triangle.hpp"
 #include "octree.hpp"
-#include "coordinates.hpp"
-#include "intersection.hpp"
+
+using namespace geometry;
 
 //-------------------------------------------------------------------------------//
 
+/**
+ * usage: ete <scene.dat> <scene.answer>
+ * runs the serial octree on the scene and compares the ids of the intersecting triags with the answer file
+*/
 int main(int argc, char **argv)
 {
-    if (argc != 2)
+    if (argc != 3)
     {
         std::cerr << "Incorrect value of args" << std::endl;
         return -1;
     }
 
-    std::ifstream test_file;
+    std::ifstream test_file{argv[1]};
+    std::ifstream answer_file{argv[2]};
 
-    test_file.open(argv[1]);
+    if (!test_file || !answer_file)
+    {
+        std::cerr << "can't open " << (test_file ? argv[2] : argv[1]) << std::endl;
+        return -1;
+    }
 
     size_t tr_numbers = 0;
-
     test_file >> tr_numbers;
 
-    const std::clock_t start = clock();
+    octrees::triag_vector triags;
+    triags.reserve(tr_numbers);
 
-    std::list<Triangle> triangles;
-
-    double BoundingBoxX = 0, BoundingBoxY = 0, BoundingBoxZ = 0;
-
-    for (int i = 0; i < tr_numbers; i++)
+    for (size_t i = 0; i < tr_numbers; i++)
     {
-        double p1x = 0, p1y = 0, p1z = 0, p2x = 0, p2y = 0, p2z = 0, p3x = 0, p3y = 0, p3z = 0;
-
-        test_file >> p1x >> p1y >> p1z;
-        Point p1(p1x, p1y, p1z);
-
-        test_file >> p2x >> p2y >> p2z;
-        Point p2(p2x, p2y, p2z);
-
-        test_file >> p3x >> p3y >> p3z;
-        Point p3(p3x, p3y, p3z);
+        double crds[9] = {};
+        for (double &crd : crds) test_file >> crd;
 
-        Triangle t(p1, p2, p3);
-
-        t.number = i;
-
-        triangles.push_back(t);
-
-        if (BoundingBoxX < std::max(std::abs(p1.X()), std::max(std::abs(p2.X()), std::abs(p3.X()))))
-            BoundingBoxX = std::max(std::abs(p1.X()), std::max(std::abs(p2.X()), std::abs(p3.X())));
-
-        if (BoundingBoxY < std::max(std::abs(p1.Y()), std::max(std::abs(p2.Y()), std::abs(p3.Y()))))
-            BoundingBoxY = std::max(std::abs(p1.Y()), std::max(std::abs(p2.Y()), std::abs(p3.Y())));
-
-        if (BoundingBoxZ < std::max(std::abs(p1.Z()), std::max(std::abs(p2.Z()), std::abs(p3.Z()))))
-            BoundingBoxZ = std::max(std::abs(p1.Z()), std::max(std::abs(p2.Z()), std::abs(p3.Z())));
+        triags.push_back({triangle_t{point_t{crds[0], crds[1], crds[2]}, point_t{crds[3], crds[4], crds[5]},
+                                     point_t{crds[6], crds[7], crds[8]}}, i});
     }
 
-    Point bounding_box(BoundingBoxX, BoundingBoxY, BoundingBoxZ);
-
-    OctreeNew oct(triangles, bounding_box);
+    if (!test_file)
+    {
+        std::cerr << argv[1] << ": expected " << tr_numbers << " triangles" << std::endl;
+        return -1;
+    }
 
-    std::set<size_t> intersecting_triangles;
+    std::vector<bool> answer(tr_numbers, false);
+    octrees::octree_t{triags}.get_collisions(answer);
 
-    bool *FlagArray = new bool [tr_numbers]{};
+    std::vector<size_t> found;
+    for (size_t i = 0; i < tr_numbers; i++)
+        if (answer[i]) found.push_back(i);
 
-    FindIntersectionsInNode(oct.root_, FlagArray);
+    std::vector<size_t> expected{std::istream_iterator<size_t>{answer_file}, std::istream_iterator<size_t>{}};
 
-    for (size_t i = 0; i < tr_numbers; i++)
+    if (found != expected)
     {
-        if (FlagArray[i])
-            std::cout << i << std::endl;
+        std::cerr << argv[1] << ": found " << found.size() << " intersecting triangles, expected " << expected.size() << std::endl;
+        return 1;
     }
 
-    std::cout << "Total time is " << (clock() - start) / (double) CLOCKS_PER_SEC << std::endl;
-
-    test_file.close();
-
     return 0;
 }
 
@@ -0,0 +1,24 @@
+#include <gtest/gtest.h>
+
+#include "engine_checks.hpp"
+
+using namespace scenes;
+
+//-------------------------------------------------------------------------------//
+
+TEST(bvh, flags_match_brute_force)
+{
+    check_flags(collisions::BVH);
+}
+
+TEST(bvh, pairs_match_brute_force)
+{
+    check_pairs(collisions::BVH);
+}
+
+TEST(bvh, empty_and_single_scenes)
+{
+    check_empty_and_single(collisions::BVH);
+}
+
+//-------------------------------------------------------------------------------//
@@ -0,0 +1,158 @@
+#include <gtest/gtest.h>
+
+#include "collisions.hpp"
+#include "scenes.hpp"
+
+using namespace scenes;
+
+//-------------------------------------------------------------------------------//
+
+namespace {
+
+const size_t MOVE_FRAMES = 20; // frames the triags take to reach their targets, they stay there afterwards
+
+/**
+ * \brief every triag of the scene moves without turning from its place towards the place of the same triag in targets,
+ *        so the leaves of a tree built on the first frame spread over the whole scene
+*/
+class deformation_t
+{
+    triag_vector start_;
+    std::vector<vector_t> moves_;
+
+    public:
+
+    deformation_t(const scene_params_t &params, unsigned seed) : start_(random_scene(params, seed))
+    {
+        triag_vector targets = random_scene(params, seed + 1);
+
+        for (size_t i = 0; i < start_.size(); ++i)
+            moves_.push_back(targets[i].triag.get_center_x3() - start_[i].triag.get_center_x3());
+    }
+
+    triag_vector frame(size_t num) const
+    {
+        /* centers x3 are moved, the triags go a third of the way */
+        double share = static_cast<double>(std::min(num, MOVE_FRAMES)) / MOVE_FRAMES / 9;
+
+        triag_vector triags = start_;
+
+        for (size_t i = 0; i < triags.size(); ++i)
+        {
+            const triangle_t &t = triags[i].triag;
+            const vector_t &move = moves_[i];
+
+            auto shift = [&move, share] (const point_t &pnt) {
+                return point_t{pnt.get_x() + share * move.get_x(), pnt.get_y() + share * move.get_y(),
+                               pnt.get_z() + share * move.get_z()};
+            };
+
+            triags[i].triag = triangle_t{shift(t.getA()), shift(t.getB()), shift(t.getC())};
+        }
+
+        return triags;
+    }
+};
+
+scene_params_t deforming_params()
+{
+    scene_params_t params;
+    params.triag_num = 1000;
+    params.extent    = 40;
+
+    return params;
+}
+
+}
+
+//-------------------------------------------------------------------------------//
+
+TEST(deforming_scene, refit_matches_a_fresh_build)
+{
+    deformation_t deformation{deforming_params(), 71};
+
+    triag_vector first = deformation.frame(0);
+
+    for (size_t thread_num : {1, 4})
+    {
+        bvh::bvh_t refit{first, thread_num};
+
+        for (size_t num = 1; num <= MOVE_FRAMES; ++num)
+        {
+            SCOPED_TRACE("frame " + std::to_string(num) + ", " + std::to_string(thread_num) + " threads");
+
+            triag_vector triags = deformation.frame(num);
+            refit.refit(triags, thread_num);
+
+            pair_vector pairs;
+            refit.get_collisions(pairs);
+
+            pair_vector built;
+            bvh::bvh_t{triags}.get_collisions(built);
+
+            ASSERT_EQ(pairs, built);
+
+            std::vector<bool> answer(triags.size(), false);
+            refit.get_collisions(answer, thread_num);
+
+            ASSERT_EQ(answer, flags_of(pairs, triags.size()));
+
+            if (num % 5 == 0)
+            {
+                ASSERT_EQ(pairs, brute_force_pairs(triags));
+            }
+        }
+
+        /* the leaves have spread over the scene */
+        EXPECT_GT(refit.get_degradation(), 2.0);
+    }
+}
+
+TEST(deforming_scene, rebuilds_once_refit_is_slower)
+{
+    deformation_t deformation{deforming_params(), 73};
+
+    collisions::deforming_scene_t scene{2};
+
+    bool fired = false, rebuilt_after = false;
+
+    /* the lost time grows by a steady share of the build frame every frame after the triags stop, so the rebuild comes */
+    for (size_t num = 0; num < 20 * MOVE_FRAMES && !rebuilt_after; ++num)
+    {
+        SCOPED_TRACE("frame " + std::to_string(num));
+
+        triag_vector triags = deformation.frame(num);
+
+        std::vector<bool> answer(triags.size(), false);
+        collisions::frame_stats_t stats = scene.frame(triags, answer);
+
+        if (num == 0)
+        {
+            EXPECT_TRUE(stats.rebuilt);
+        }
+
+        if (fired)
+        {
+            /* the frame after the flag builds the tree from scratch */
+            ASSERT_TRUE(stats.rebuilt);
+            EXPECT_DOUBLE_EQ(stats.degradation, 1);
+
+            rebuilt_after = true;
+        }
+        else if (num > 0)
+        {
+            EXPECT_FALSE(stats.rebuilt);
+        }
+
+        fired = stats.rebuild_cheaper;
+
+        if (num % 5 == 0 || stats.rebuilt)
+        {
+            ASSERT_EQ(answer, brute_force(triags));
+        }
+    }
+
+    EXPECT_TRUE(rebuilt_after);
+}
+
+//-------------------------------------------------------------------------------//
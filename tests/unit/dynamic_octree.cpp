@@ -0,0 +1,182 @@
+#include <gtest/gtest.h>
+
+#include "dynamic_octree.hpp"
+#include "scenes.hpp"
+#include <map>
+#include <random>
+
+using namespace scenes;
+
+//-------------------------------------------------------------------------------//
+
+namespace {
+
+triangle_t shifted(const triangle_t &triag, double dx, double dy, double dz)
+{
+    auto shift = [=] (const point_t &pnt) { return point_t{pnt.get_x() + dx, pnt.get_y() + dy, pnt.get_z() + dz}; };
+
+    return {shift(triag.getA()), shift(triag.getB()), shift(triag.getC())};
+}
+
+/**
+ * \brief the live set of the tree must give the same pairs as a static octree built from scratch and as brute force
+*/
+void check_live_set(const octrees::dynamic_octree_t &tree, const std::map<size_t, triangle_t> &live)
+{
+    triag_vector triags;
+    size_t id_num = 0;
+
+    for (auto &it : live)
+    {
+        triags.push_back({it.second, it.first});
+        id_num = it.first + 1;
+    }
+
+    ASSERT_EQ(tree.triag_num(), live.size());
+
+    pair_vector pairs;
+    tree.get_collisions(pairs);
+
+    pair_vector expected = brute_force_pairs(triags);
+    ASSERT_EQ(pairs, expected);
+
+    pair_vector built;
+    octrees::octree_t{triags}.get_collisions(built);
+    ASSERT_EQ(pairs, built);
+
+    std::vector<bool> answer(id_num, false);
+    tree.get_collisions(answer);
+
+    ASSERT_EQ(answer, flags_of(expected, id_num));
+    ASSERT_EQ(tree.colliding_num(), count(answer));
+
+    for (auto &it : live) ASSERT_EQ(tree.is_colliding(it.first), answer[it.first]);
+}
+
+/**
+ * \brief random inserts, erases and updates, some of the updates move a triag far out of the root cube
+*/
+void run_edits(octrees::dynamic_octree_t &tree, std::map<size_t, triangle_t> &live, const triag_vector &pool, unsigned seed)
+{
+    std::mt19937_64 gen{seed};
+
+    std::uniform_int_distribution<size_t>  id_dist{0, pool.size() - 1};
+    std::uniform_int_distribution<int>     op_dist{0, 99};
+    std::uniform_real_distribution<double> move_dist{-3, 3};
+    std::uniform_real_distribution<double> far_dist{-2000, 2000};
+
+    for (int step = 0; step < 3000; ++step)
+    {
+        size_t id = id_dist(gen);
+        int    op = op_dist(gen);
+
+        if (!live.count(id))
+        {
+            ASSERT_FALSE(tree.erase(id));
+            ASSERT_TRUE(tree.insert(pool[id]));
+
+            live.insert_or_assign(id, pool[id].triag);
+        }
+        else if (op < 35)
+        {
+            ASSERT_TRUE(tree.erase(id));
+            live.erase(id);
+        }
+        else
+        {
+            bool far = (op >= 97);
+
+            triangle_t moved = far ? shifted(live.at(id), far_dist(gen), far_dist(gen), far_dist(gen))
+                                   : shifted(live.at(id), move_dist(gen), move_dist(gen), move_dist(gen));
+
+            ASSERT_FALSE(tree.insert({moved, id}));
+            ASSERT_TRUE(tree.update(id, moved));
+
+            live.insert_or_assign(id, moved);
+        }
+
+        if (step % 150 == 0) check_live_set(tree, live);
+    }
+
+    check_live_set(tree, live);
+}
+
+}
+
+//-------------------------------------------------------------------------------//
+
+TEST(dynamic_octree, edits_match_a_fresh_build)
+{
+    scene_params_t params;
+    params.triag_num = 700;
+    params.extent    = 30;
+    params.max_size  = 6;
+
+    triag_vector pool = random_scene(params, 61);
+
+    /* half of the pool is built at once, the other half comes by inserts */
+    triag_vector initial(pool.begin(), pool.begin() + pool.size() / 2);
+
+    octrees::dynamic_octree_t tree{initial, 8};
+
+    std::map<size_t, triangle_t> live;
+    for (auto &it : initial) live.insert_or_assign(it.id, it.triag);
+
+    check_live_set(tree, live);
+    run_edits(tree, live, pool, 62);
+}
+
+TEST(dynamic_octree, empty_tree_takes_the_first_triag)
+{
+    scene_params_t params;
+    params.triag_num = 600;
+    params.extent    = 20;
+    params.max_size  = 4;
+
+    triag_vector pool = random_scene(params, 63);
+
+    /* the scene is far from the origin, an empty tree must not keep a unit cube there */
+    for (auto &it : pool) it.triag = shifted(it.triag, 1e4, -1e4, 5e3);
+
+    octrees::dynamic_octree_t tree{{}, 8};
+    std::map<size_t, triangle_t> live;
+
+    run_edits(tree, live, pool, 64);
+
+    EXPECT_GT(tree.root_pos().rad_, 20.0);
+    EXPECT_GT(tree.node_num(), 1u);
+}
+
+TEST(dynamic_octree, root_grows_to_far_inserts)
+{
+    triag_vector pool = random_scene(scene_params_t{400}, 65);
+    triag_vector near(pool.begin(), pool.begin() + 200);
+
+    octrees::dynamic_octree_t tree{near, 8};
+    double first_rad = tree.root_pos().rad_;
+
+    std::map<size_t, triangle_t> live;
+    for (auto &it : near) live.insert_or_assign(it.id, it.triag);
+
+    /* the other half goes into a cluster far outside of the root cube */
+    for (size_t i = 200; i < pool.size(); ++i)
+    {
+        triangle_t far = shifted(pool[i].triag, 5e4, 5e4, -5e4);
+
+        ASSERT_TRUE(tree.insert({far, i}));
+        live.insert_or_assign(i, far);
+    }
+
+    EXPECT_GT(tree.root_pos().rad_, first_rad);
+    check_live_set(tree, live);
+
+    for (size_t i = 0; i < pool.size(); i += 2)
+    {
+        ASSERT_TRUE(tree.erase(i));
+        live.erase(i);
+    }
+
+    check_live_set(tree, live);
+}
+
+//-------------------------------------------------------------------------------//
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include "collisions.hpp"
+#include "scenes.hpp"
+#include <string>
+#include <vector>
+
+namespace scenes {
+
+const size_t THREAD_NUMS[] = {1, 4};
+
+/**
+ * \brief scenes of test_scenes(), generated once for all the tests
+*/
+inline const std::vector<triag_vector>& get_scenes()
+{
+    static const std::vector<triag_vector> all = [] {
+        std::vector<triag_vector> scenes;
+
+        unsigned seed = 1;
+        for (const scene_params_t &params : test_scenes()) scenes.push_back(random_scene(params, seed++));
+
+        return scenes;
+    }();
+
+    return all;
+}
+
+inline const std::vector<bool>& get_expected(size_t scene)
+{
+    static const std::vector<std::vector<bool>> expected = [] {
+        std::vector<std::vector<bool>> answers;
+        for (const triag_vector &triags : get_scenes()) answers.push_back(brute_force(triags));
+
+        return answers;
+    }();
+
+    return expected[scene];
+}
+
+/**
+ * \brief flags of the engine on every test scene at every thread number are the brute force ones
+*/
+inline void check_flags(collisions::engine_type engine)
+{
+    for (size_t scene = 0; scene < get_scenes().size(); ++scene)
+    {
+        const triag_vector &triags = get_scenes()[scene];
+        ASSERT_GT(count(get_expected(scene)), 0u);
+
+        for (size_t thread_num : THREAD_NUMS)
+        {
+            SCOPED_TRACE(std::string{collisions::engine_names[engine]} + ", scene " + std::to_string(scene) +
+                         ", " + std::to_string(thread_num) + " threads");
+
+            collisions::engine_params_t params;
+            params.thread_num = thread_num;
+
+            std::vector<bool> answer(triags.size(), false);
+            collisions::find_collisions(engine, triags, answer, params);
+
+            EXPECT_EQ(answer, get_expected(scene));
+        }
+    }
+}
+
+/**
+ * \brief same for the sorted pairs
+*/
+inline void check_pairs(collisions::engine_type engine)
+{
+    for (size_t scene = 0; scene < get_scenes().size(); ++scene)
+    {
+        const triag_vector &triags = get_scenes()[scene];
+        pair_vector expected = brute_force_pairs(triags);
+
+        for (size_t thread_num : THREAD_NUMS)
+        {
+            SCOPED_TRACE(std::string{collisions::engine_names[engine]} + ", scene " + std::to_string(scene) +
+                         ", " + std::to_string(thread_num) + " threads");
+
+            collisions::engine_params_t params;
+            params.thread_num = thread_num;
+
+            pair_vector pairs;
+            collisions::find_collisions(engine, triags, pairs, params);
+
+            EXPECT_EQ(pairs, expected);
+        }
+    }
+}
+
+/**
+ * \brief the engine runs on an empty scene and finds nothing in a single triag
+*/
+inline void check_empty_and_single(collisions::engine_type engine)
+{
+    SCOPED_TRACE(collisions::engine_names[engine]);
+
+    triag_vector single = random_scene(scene_params_t{1}, 7);
+
+    std::vector<bool> none;
+    collisions::find_collisions(engine, {}, none, collisions::engine_params_t{4});
+
+    std::vector<bool> one(1, false);
+    collisions::find_collisions(engine, single, one, collisions::engine_params_t{4});
+
+    EXPECT_FALSE(one[0]);
+}
+
+}
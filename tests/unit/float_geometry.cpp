@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+
+#include "scenes.hpp"
+#include "triangle.hpp"
+
+using namespace scenes;
+
+using float_triangle_t = geometry::basic_triangle_t<float>;
+using float_point_t    = geometry::basic_point_t<float>;
+
+//-------------------------------------------------------------------------------//
+
+namespace {
+
+/**
+ * \brief small integer vertices, they are exact in float and the products of the tests stay far from its precision
+*/
+scene_params_t grid_params()
+{
+    scene_params_t params;
+    params.triag_num = 400;
+    params.extent    = 12;
+    params.max_size  = 6;
+    params.step      = 1;
+
+    return params;
+}
+
+float_triangle_t to_float(const triangle_t &triag)
+{
+    return {float_point_t{triag.getA()}, float_point_t{triag.getB()}, float_point_t{triag.getC()}};
+}
+
+}
+
+//-------------------------------------------------------------------------------//
+
+TEST(float_geometry, tolerance_follows_the_type)
+{
+    EXPECT_TRUE (doperations::is_equal(1.0f, 1.0f + 5e-5f));
+    EXPECT_FALSE(doperations::is_equal(1.0,  1.0  + 5e-5));
+    EXPECT_DOUBLE_EQ(doperations::ACCURACY, doperations::accuracy<double>::value);
+}
+
+TEST(float_geometry, float_triags_match_double)
+{
+    triag_vector triags = random_scene(grid_params(), 101);
+
+    std::vector<float_triangle_t> floats;
+    for (auto &it : triags) floats.push_back(to_float(it.triag));
+
+    size_t hit_num = 0, differ_num = 0;
+
+    for (size_t i = 0; i < triags.size(); ++i)
+    {
+        EXPECT_EQ(floats[i].get_type(), triags[i].triag.get_type()) << "triag " << i;
+
+        for (size_t j = i + 1; j < triags.size(); ++j)
+        {
+            bool expected = triags[i].triag.intersects(triags[j].triag);
+
+            hit_num    += expected;
+            differ_num += (floats[i].intersects(floats[j]) != expected);
+
+            /* the vertices are the same in both types, so the exact test gives the same answer */
+            ASSERT_EQ(floats[i].intersects_exact(floats[j]), triags[i].triag.intersects_exact(triags[j].triag))
+                << "triags " << i << " " << j;
+        }
+    }
+
+    /* the scene is dense enough for the comparison to mean something */
+    EXPECT_GT(hit_num, triags.size() / 4);
+
+    /* the line of two planes is anchored on a coordinate plane far from the triags, there float loses the digits
+       that decide the touching pairs, so a few of them may differ */
+    EXPECT_LE(differ_num, hit_num / 50);
+}
+
+TEST(float_geometry, float_ray_hits_match_double)
+{
+    triangle_t triag{point_t{0, 0, 0}, point_t{4, 0, 0}, point_t{0, 4, 0}};
+    float_triangle_t ftriag = to_float(triag);
+
+    using float_ray_t    = geometry::basic_ray_t<float>;
+    using float_vector_t = geometry::basic_vector_t<float>;
+
+    EXPECT_FLOAT_EQ(ftriag.intersect_ray(float_ray_t{float_point_t{1, 1, 3}, float_vector_t{0, 0, -2}}), 1.5f);
+    EXPECT_TRUE(std::isnan(ftriag.intersect_ray(float_ray_t{float_point_t{3, 3, 3}, float_vector_t{0, 0, -1}})));
+}
+
+//-------------------------------------------------------------------------------//
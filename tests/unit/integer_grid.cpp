@@ -0,0 +1,134 @@
+#include <gtest/gtest.h>
+
+#include "integer_grid.hpp"
+#include "scenes.hpp"
+
+using namespace scenes;
+
+//-------------------------------------------------------------------------------//
+
+namespace {
+
+/* quarters are exact doubles, so the exact double test sees the same points as the grid */
+triag_vector grid_scene(double step, unsigned seed)
+{
+    scene_params_t params;
+    params.triag_num  = 2000;
+    params.extent     = 50;
+    params.max_size   = 6;
+    params.degenerate = 0.1;
+    params.flat       = 0.3;
+    params.step       = step;
+
+    return random_scene(params, seed);
+}
+
+std::vector<bool> exact_brute_force(const triag_vector &triags)
+{
+    return brute_force(triags, [] (const triangle_t &a, const triangle_t &b) { return a.intersects_exact(b); });
+}
+
+}
+
+//-------------------------------------------------------------------------------//
+
+TEST(integer_grid, finds_the_coarsest_grid)
+{
+    EXPECT_EQ(grids::find_grid_scale(grid_scene(1, 31)), 1);
+    EXPECT_EQ(grids::find_grid_scale(grid_scene(0.25, 32)), 100);
+    EXPECT_EQ(grids::find_grid_scale(random_scene(scene_params_t{100}, 33)), 0);
+}
+
+TEST(integer_grid, decimals_are_on_the_grid)
+{
+    /* none of these is an exact double, crd * scale misses the integer by the rounding of the input */
+    triag_vector triags = random_scene(scene_params_t{500}, 35);
+
+    for (auto &it : triags)
+    {
+        auto tenth = [] (double crd) { return std::round(crd * 10) / 10; };
+        const triangle_t &t = it.triag;
+
+        it.triag = triangle_t{point_t{tenth(t.getA().get_x()), tenth(t.getA().get_y()), 0.3},
+                              point_t{tenth(t.getB().get_x()), tenth(t.getB().get_y()), 0.7},
+                              point_t{tenth(t.getC().get_x()), tenth(t.getC().get_y()), -1.1}};
+    }
+
+    EXPECT_EQ(grids::find_grid_scale(triags), 10);
+}
+
+TEST(integer_grid, vertices_are_not_moved)
+{
+    /* a point 1e-7 above the plane of a triag: on no grid up to 10^-6, so the integer path must not snap it onto the plane */
+    triag_vector triags = {{triangle_t{point_t{0, 0, 0}, point_t{10, 0, 0}, point_t{0, 10, 0}}, 0},
+                           {triangle_t{point_t{1, 1, 1e-7}, point_t{2, 1, 5}, point_t{1, 2, 5}}, 1}};
+
+    EXPECT_FALSE(triags[0].triag.intersects_exact(triags[1].triag));
+    EXPECT_EQ(grids::find_grid_scale(triags), 0);
+
+    /* raised to 1e-6 the point is on the finest grid, both paths see it above the plane */
+    triags[1].triag = triangle_t{point_t{1, 1, 1e-6}, point_t{2, 1, 5}, point_t{1, 2, 5}};
+
+    int64_t scale = grids::find_grid_scale(triags);
+    ASSERT_EQ(scale, 1000000);
+
+    std::vector<bool> answer(2, false);
+    grids::int_sweep_t{triags, scale}.get_collisions(answer);
+
+    EXPECT_EQ(answer, exact_brute_force(triags));
+    EXPECT_FALSE(answer[0]);
+
+    /* and one that touches the plane is found by both */
+    triags[1].triag = triangle_t{point_t{1, 1, 0}, point_t{2, 1, 5}, point_t{1, 2, 5}};
+
+    answer.assign(2, false);
+    grids::int_sweep_t{triags, grids::find_grid_scale(triags)}.get_collisions(answer);
+
+    EXPECT_EQ(answer, exact_brute_force(triags));
+    EXPECT_TRUE(answer[0]);
+}
+
+TEST(integer_grid, off_grid_coordinate_is_rejected)
+{
+    triag_vector triags = grid_scene(0.25, 36);
+    ASSERT_EQ(grids::find_grid_scale(triags), 100);
+
+    const triangle_t &t = triags[7].triag;
+    triags[7].triag = triangle_t{t.getA(), t.getB(), point_t{t.getC().get_x() + 1e-9, t.getC().get_y(), t.getC().get_z()}};
+
+    EXPECT_EQ(grids::find_grid_scale(triags), 0);
+}
+
+TEST(integer_grid, sweep_matches_exact_brute_force)
+{
+    for (double step : {1.0, 0.25})
+    {
+        triag_vector triags = grid_scene(step, 34);
+
+        int64_t scale = grids::find_grid_scale(triags);
+        ASSERT_NE(scale, 0);
+
+        std::vector<bool> expected = exact_brute_force(triags);
+        ASSERT_GT(count(expected), 0u);
+
+        for (size_t thread_num : {1, 4})
+        {
+            SCOPED_TRACE("step " + std::to_string(step) + ", " + std::to_string(thread_num) + " threads");
+
+            grids::int_sweep_t sweep{triags, scale};
+
+            std::vector<bool> answer(triags.size(), false);
+            sweep.get_collisions(answer, thread_num);
+
+            EXPECT_EQ(answer, expected);
+
+            pair_vector pairs;
+            sweep.get_collisions(pairs, thread_num);
+
+            EXPECT_EQ(flags_of(pairs, triags.size()), expected);
+            EXPECT_TRUE(std::is_sorted(pairs.begin(), pairs.end()));
+        }
+    }
+}
+
+//-------------------------------------------------------------------------------//
@@ -0,0 +1,24 @@
+#include <gtest/gtest.h>
+
+#include "engine_checks.hpp"
+
+using namespace scenes;
+
+//-------------------------------------------------------------------------------//
+
+TEST(linear_octree, flags_match_brute_force)
+{
+    check_flags(collisions::LINEAR_OCTREE);
+}
+
+TEST(linear_octree, pairs_match_brute_force)
+{
+    check_pairs(collisions::LINEAR_OCTREE);
+}
+
+TEST(linear_octree, empty_and_single_scenes)
+{
+    check_empty_and_single(collisions::LINEAR_OCTREE);
+}
+
+//-------------------------------------------------------------------------------//
@@ -0,0 +1,107 @@
+#include <gtest/gtest.h>
+
+#include "engine_checks.hpp"
+
+using namespace scenes;
+
+//-------------------------------------------------------------------------------//
+
+TEST(octree, flags_match_brute_force)
+{
+    check_flags(collisions::OCTREE);
+}
+
+TEST(octree, pairs_match_brute_force)
+{
+    check_pairs(collisions::OCTREE);
+}
+
+TEST(octree, empty_and_single_scenes)
+{
+    check_empty_and_single(collisions::OCTREE);
+}
+
+TEST(octree, params_keep_the_answer)
+{
+    std::vector<octrees::octree_params_t> all_params(6);
+
+    all_params[1].loose_factor = 2;
+    all_params[2].leaf_size    = 4;
+    all_params[3].leaf_size    = octrees::AUTO_LEAF_SIZE;
+    all_params[4].max_depth    = 2;
+    all_params[5].float_filter = true;
+
+    for (size_t scene = 0; scene < get_scenes().size(); ++scene)
+        for (size_t i = 0; i < all_params.size(); ++i)
+            for (size_t thread_num : THREAD_NUMS)
+            {
+                SCOPED_TRACE("scene " + std::to_string(scene) + ", params " + std::to_string(i) + ", " +
+                             std::to_string(thread_num) + " threads");
+
+                octrees::octree_params_t params = all_params[i];
+                params.thread_num = thread_num;
+
+                octrees::octree_t tree{get_scenes()[scene], params};
+
+                std::vector<bool> answer(get_scenes()[scene].size(), false);
+                tree.get_collisions(answer, thread_num);
+
+                EXPECT_EQ(answer, get_expected(scene));
+            }
+}
+
+TEST(octree, stats_answer_matches)
+{
+    const triag_vector &triags = get_scenes()[0];
+
+    octrees::stats_answer_t answer{std::vector<bool>(triags.size(), false), {}};
+    collisions::find_collisions(collisions::OCTREE, triags, answer, collisions::engine_params_t{4});
+
+    EXPECT_EQ(answer.flags, get_expected(0));
+    EXPECT_GE(answer.stats.candidates, answer.stats.intersecting);
+}
+
+TEST(octree, tests_border_pairs_once)
+{
+    /* triags as large as the scene, most of them stay in the border list of the root */
+    scene_params_t params;
+    params.triag_num = 400;
+    params.extent    = 10;
+    params.min_size  = 20;
+    params.max_size  = 40;
+
+    triag_vector triags = random_scene(params, 9);
+
+    octrees::octree_t tree{triags, octrees::octree_params_t{}};
+    EXPECT_GT(tree.border_fraction(), 0.5);
+
+    octrees::stats_answer_t answer{std::vector<bool>(triags.size(), false), {}};
+    tree.get_collisions(answer);
+
+    EXPECT_EQ(answer.flags, brute_force(triags));
+    EXPECT_EQ(answer.stats.candidates, tree.pair_test_num());
+    EXPECT_LE(answer.stats.candidates, triags.size() * (triags.size() - 1) / 2);
+}
+
+TEST(octree, exact_answer_matches_brute_force)
+{
+    auto exact = [] (const triangle_t &a, const triangle_t &b) { return a.intersects_exact(b); };
+
+    for (size_t scene = 0; scene < get_scenes().size(); ++scene)
+    {
+        const triag_vector &triags = get_scenes()[scene];
+        std::vector<bool> expected = brute_force(triags, exact);
+
+        for (size_t thread_num : THREAD_NUMS)
+        {
+            SCOPED_TRACE("scene " + std::to_string(scene) + ", " + std::to_string(thread_num) + " threads");
+
+            octrees::exact_answer_t answer{std::vector<bool>(triags.size(), false)};
+            collisions::find_collisions(collisions::OCTREE, triags, answer, collisions::engine_params_t{thread_num});
+
+            EXPECT_EQ(answer.flags, expected);
+        }
+    }
+}
+
+//-------------------------------------------------------------------------------//
@@ -0,0 +1,217 @@
+#include <gtest/gtest.h>
+
+#include "octree.hpp"
+#include "scenes.hpp"
+#include <filesystem>
+#include <fstream>
+
+using namespace scenes;
+
+//-------------------------------------------------------------------------------//
+
+namespace {
+
+std::string index_path(const std::string &name)
+{
+    return (std::filesystem::temp_directory_path() / name).string();
+}
+
+int patch_num = 0;
+
+/**
+ * \brief copy of the index at path with value written over the element at offset, returns its path
+*/
+template <typename T>
+std::string patched_index(const std::string &path, uint64_t offset, const T &value)
+{
+    std::string patched = path + "." + std::to_string(patch_num++);
+    std::filesystem::copy_file(path, patched, std::filesystem::copy_options::overwrite_existing);
+
+    std::fstream file{patched, std::ios::binary | std::ios::in | std::ios::out};
+    file.seekp(static_cast<std::streamoff>(offset));
+    file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+
+    return patched;
+}
+
+template <typename T>
+T read_at(const std::string &path, uint64_t offset)
+{
+    T value{};
+
+    std::ifstream file{path, std::ios::binary};
+    file.seekg(static_cast<std::streamoff>(offset));
+    file.read(reinterpret_cast<char*>(&value), sizeof(value));
+
+    return value;
+}
+
+}
+
+//-------------------------------------------------------------------------------//
+
+TEST(octree_index, opened_tree_gives_the_same_answer)
+{
+    std::string path = index_path("triag_octree_index_test.idx");
+
+    for (double loose_factor : {1.0, 2.0})
+    {
+        SCOPED_TRACE("loose factor " + std::to_string(loose_factor));
+
+        triag_vector triags = random_scene(test_scenes()[1], 51);
+
+        octrees::octree_params_t params;
+        params.loose_factor = loose_factor;
+
+        octrees::octree_t built{triags, params};
+        built.save_index(path);
+
+        for (bool float_filter : {false, true})
+        {
+            octrees::octree_t opened = octrees::octree_t::open_index(path, float_filter);
+
+            EXPECT_EQ(opened.node_num(), built.node_num());
+            EXPECT_EQ(opened.is_loose(), built.is_loose());
+            EXPECT_EQ(opened.leaf_size(), built.leaf_size());
+            EXPECT_EQ(opened.is_float_filtered(), float_filter);
+
+            std::vector<bool> expected = brute_force(triags);
+
+            for (size_t thread_num : {1, 4})
+            {
+                std::vector<bool> answer(triags.size(), false);
+                opened.get_collisions(answer, thread_num);
+
+                EXPECT_EQ(answer, expected);
+            }
+
+            pair_vector pairs;
+            opened.get_collisions(pairs);
+
+            EXPECT_EQ(pairs, brute_force_pairs(triags));
+        }
+    }
+
+    std::filesystem::remove(path);
+}
+
+TEST(octree_index, rejects_other_files)
+{
+    std::string path = index_path("triag_octree_not_index_test.idx");
+
+    {
+        std::ofstream out{path, std::ios::binary};
+        out << "not an octree index, just some text that is long enough to hold a header";
+    }
+
+    EXPECT_THROW(octrees::octree_t::open_index(path), std::runtime_error);
+    EXPECT_THROW(octrees::octree_t::open_index(index_path("triag_octree_missing_test.idx")), std::runtime_error);
+
+    std::filesystem::remove(path);
+}
+
+TEST(octree_index, rejects_truncated_files)
+{
+    std::string path = index_path("triag_octree_truncated_test.idx");
+
+    octrees::octree_t{random_scene(test_scenes()[0], 52)}.save_index(path);
+
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) / 2);
+    EXPECT_THROW(octrees::octree_t::open_index(path), std::runtime_error);
+
+    std::filesystem::remove(path);
+}
+
+TEST(octree_index, rejects_corrupt_files)
+{
+    using octrees::detail::node_t;
+    using octrees::detail::index_header_t;
+
+    std::string path = index_path("triag_octree_corrupt_test.idx");
+
+    octrees::octree_t built{random_scene(test_scenes()[0], 53)};
+    ASSERT_GT(built.node_num(), 1u);
+
+    built.save_index(path);
+    ASSERT_NO_THROW(octrees::octree_t::open_index(path));
+
+    index_header_t header = read_at<index_header_t>(path, 0);
+
+    auto node_at = [&header] (size_t idx) { return header.nodes_offset + idx * sizeof(node_t); };
+
+    size_t leaf = 1;
+    while (!read_at<node_t>(path, node_at(leaf)).is_leaf()) ++leaf;
+
+    octrees::index_t node_num  = static_cast<octrees::index_t>(header.node_num);
+    octrees::index_t triag_num = static_cast<octrees::index_t>(header.triag_num);
+
+    std::vector<std::string> patched = {
+        patched_index(path, node_at(0) + offsetof(node_t, child_), node_num - 1), // children past the last node
+        patched_index(path, node_at(0) + offsetof(node_t, child_), ~octrees::index_t{0}),
+        patched_index(path, node_at(leaf) + offsetof(node_t, child_), octrees::index_t{1}), // children before the node
+        patched_index(path, node_at(leaf) + offsetof(node_t, last_), triag_num + 1),
+        patched_index(path, node_at(leaf) + offsetof(node_t, border_), triag_num),
+        patched_index(path, node_at(0) + offsetof(node_t, last_), triag_num - 1),
+        patched_index(path, header.triags_offset + offsetof(octrees::triag_id_t, id), size_t{1} << 40),
+        patched_index(path, offsetof(index_header_t, box_num), header.node_num),
+        patched_index(path, offsetof(index_header_t, triag_num), uint64_t{1} << 60),
+        patched_index(path, offsetof(index_header_t, block_offset), header.block_offset + 8)
+    };
+
+    for (size_t i = 0; i < patched.size(); ++i)
+    {
+        SCOPED_TRACE("patch " + std::to_string(i));
+        EXPECT_THROW(octrees::octree_t::open_index(patched[i]), std::runtime_error);
+
+        std::filesystem::remove(patched[i]);
+    }
+
+    std::filesystem::remove(path);
+}
+
+TEST(octree_index, rejects_small_trees_and_bad_types)
+{
+    using octrees::detail::node_t;
+    using octrees::detail::index_header_t;
+
+    std::string path = index_path("triag_octree_small_test.idx");
+
+    /* fewer triags than a leaf holds, the tree is the root alone */
+    octrees::octree_t built{random_scene(scene_params_t{20}, 54)};
+    ASSERT_EQ(built.node_num(), 1u);
+
+    built.save_index(path);
+    ASSERT_NO_THROW(octrees::octree_t::open_index(path));
+
+    index_header_t header = read_at<index_header_t>(path, 0);
+
+    std::vector<std::string> patched;
+
+    /* the root points to children, but there are less than child_num nodes for them */
+    for (uint64_t node_num = 1; node_num < uint64_t{octrees::child_num}; ++node_num)
+    {
+        std::string with_num = patched_index(path, offsetof(index_header_t, node_num), node_num);
+        patched.push_back(patched_index(with_num, header.nodes_offset + offsetof(node_t, child_), octrees::index_t{1}));
+
+        std::filesystem::remove(with_num);
+    }
+
+    /* the type of a triangle_t follows its three vertices */
+    size_t type_offset = header.triags_offset + offsetof(octrees::triag_id_t, triag) + 3 * sizeof(point_t);
+    ASSERT_LE(read_at<unsigned>(path, type_offset), unsigned{POINT});
+
+    patched.push_back(patched_index(path, type_offset, int{7}));
+    patched.push_back(patched_index(path, type_offset, int{-1}));
+
+    for (size_t i = 0; i < patched.size(); ++i)
+    {
+        SCOPED_TRACE("patch " + std::to_string(i));
+        EXPECT_THROW(octrees::octree_t::open_index(patched[i]), std::runtime_error);
+
+        std::filesystem::remove(patched[i]);
+    }
+
+    std::filesystem::remove(path);
+}
+
+//-------------------------------------------------------------------------------//
@@ -0,0 +1,163 @@
+#include <gtest/gtest.h>
+
+#include "octree.hpp"
+#include "scenes.hpp"
+#include <random>
+
+using namespace scenes;
+using octrees::max_min_crds_t;
+
+//-------------------------------------------------------------------------------//
+
+namespace {
+
+const size_t SHAPE_NUM = 300;
+
+/**
+ * \brief ids of the triags that intersect shape by the same exact test the tree uses, every triag is tested
+*/
+template <typename shape_t>
+std::vector<size_t> linear_scan(const triag_vector &triags, const shape_t &shape)
+{
+    std::vector<size_t> ids;
+
+    for (auto &it : triags)
+        if (octrees::detail::hits(it.triag, shape)) ids.push_back(it.id);
+
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+std::vector<triangle_t> random_triags(unsigned seed)
+{
+    scene_params_t params;
+    params.triag_num = SHAPE_NUM;
+    params.min_size  = 10;
+    params.max_size  = 60;
+
+    std::vector<triangle_t> shapes;
+    for (auto &it : random_scene(params, seed)) shapes.push_back(it.triag);
+
+    return shapes;
+}
+
+std::vector<max_min_crds_t> random_boxes(unsigned seed)
+{
+    std::mt19937_64 gen{seed};
+
+    std::uniform_real_distribution<double> center_dist{-110, 110};
+    std::uniform_real_distribution<double> size_dist{0, 25};
+
+    std::vector<max_min_crds_t> boxes;
+
+    for (size_t i = 0; i < SHAPE_NUM; ++i)
+    {
+        double x = center_dist(gen), y = center_dist(gen), z = center_dist(gen);
+
+        max_min_crds_t box{};
+        box.update(x - size_dist(gen), y - size_dist(gen), z - size_dist(gen));
+        box.update(x + size_dist(gen), y + size_dist(gen), z + size_dist(gen));
+
+        boxes.push_back(box);
+    }
+
+    /* flat and point boxes */
+    boxes[0] = max_min_crds_t{};
+    boxes[0].update(-50, -50, 0);
+    boxes[0].update(50, 50, 0);
+
+    boxes[1] = max_min_crds_t{};
+    boxes[1].update(0, 0, 0);
+
+    return boxes;
+}
+
+std::vector<octrees::sphere_t> random_spheres(unsigned seed)
+{
+    std::mt19937_64 gen{seed};
+
+    std::uniform_real_distribution<double> center_dist{-110, 110};
+    std::uniform_real_distribution<double> rad_dist{0, 25};
+
+    std::vector<octrees::sphere_t> spheres;
+
+    for (size_t i = 0; i < SHAPE_NUM; ++i)
+        spheres.push_back({point_t{center_dist(gen), center_dist(gen), center_dist(gen)}, rad_dist(gen)});
+
+    spheres[0].rad = 0;
+
+    return spheres;
+}
+
+/**
+ * \brief every shape queried alone and in a batch gives the ids of the linear scan
+*/
+template <typename shape_t>
+void check_queries(const octrees::octree_t &tree, const triag_vector &triags, const std::vector<shape_t> &shapes)
+{
+    size_t hit_num = 0;
+
+    std::vector<std::vector<size_t>> expected;
+    for (const shape_t &shape : shapes)
+    {
+        expected.push_back(linear_scan(triags, shape));
+        hit_num += !expected.back().empty();
+    }
+
+    /* most shapes have to hit something or the comparison says little */
+    ASSERT_GT(hit_num, shapes.size() / 2);
+
+    for (size_t i = 0; i < shapes.size(); ++i) ASSERT_EQ(tree.query(shapes[i]), expected[i]) << "shape " << i;
+
+    for (size_t thread_num : {1, 4}) EXPECT_EQ(tree.query(shapes, thread_num), expected);
+}
+
+}
+
+//-------------------------------------------------------------------------------//
+
+TEST(octree_query, shapes_match_linear_scan)
+{
+    triag_vector triags = random_scene(test_scenes()[1], 81);
+
+    std::vector<triangle_t>        shape_triags = random_triags(82);
+    std::vector<max_min_crds_t>    boxes        = random_boxes(83);
+    std::vector<octrees::sphere_t> spheres      = random_spheres(84);
+
+    for (double loose_factor : {1.0, 2.0})
+        for (bool float_filter : {false, true})
+        {
+            SCOPED_TRACE("loose factor " + std::to_string(loose_factor) + (float_filter ? ", float" : ""));
+
+            octrees::octree_params_t params;
+            params.loose_factor = loose_factor;
+            params.leaf_size    = 16;
+            params.float_filter = float_filter;
+
+            octrees::octree_t tree{triags, params};
+            ASSERT_GT(tree.node_num(), 1u);
+
+            {
+                SCOPED_TRACE("triags");
+                check_queries(tree, triags, shape_triags);
+            }
+            {
+                SCOPED_TRACE("boxes");
+                check_queries(tree, triags, boxes);
+            }
+            {
+                SCOPED_TRACE("spheres");
+                check_queries(tree, triags, spheres);
+            }
+        }
+}
+
+TEST(octree_query, empty_tree_finds_nothing)
+{
+    octrees::octree_t tree{triag_vector{}};
+
+    EXPECT_TRUE(tree.query(random_spheres(85)[3]).empty());
+    EXPECT_EQ(tree.query(random_boxes(86), 4), std::vector<std::vector<size_t>>(SHAPE_NUM));
+}
+
+//-------------------------------------------------------------------------------//
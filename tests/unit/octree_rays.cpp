@@ -0,0 +1,190 @@
+#include <gtest/gtest.h>
+
+#include "octree.hpp"
+#include "ray.hpp"
+#include "scenes.hpp"
+#include <cmath>
+#include <random>
+
+using namespace scenes;
+using octrees::ray_hit_t;
+
+//-------------------------------------------------------------------------------//
+
+namespace {
+
+const size_t RAY_NUM = 400;
+
+/**
+ * \brief every hit up to max_dist sorted by distance and id, every triag is tested
+*/
+std::vector<ray_hit_t> brute_force_hits(const triag_vector &triags, const ray_t &ray, double max_dist)
+{
+    std::vector<ray_hit_t> hits;
+
+    for (auto &it : triags)
+    {
+        double dist = it.triag.intersect_ray(ray);
+        if (dist <= max_dist) hits.push_back({it.id, dist});
+    }
+
+    std::sort(hits.begin(), hits.end(), [] (const ray_hit_t &a, const ray_hit_t &b) {
+        return (a.dist != b.dist) ? a.dist < b.dist : a.id < b.id;
+    });
+
+    return hits;
+}
+
+/**
+ * \brief origins inside and outside of the scene, directions of random length, some of them along an axis
+*/
+std::vector<ray_t> random_rays(unsigned seed)
+{
+    std::mt19937_64 gen{seed};
+
+    std::uniform_real_distribution<double> origin_dist{-150, 150};
+    std::uniform_real_distribution<double> dir_dist{-1, 1};
+    std::uniform_real_distribution<double> len_dist{0.1, 10};
+
+    std::vector<ray_t> rays;
+
+    for (size_t i = 0; i < RAY_NUM; ++i)
+    {
+        point_t origin{origin_dist(gen), origin_dist(gen), origin_dist(gen)};
+        double len = len_dist(gen);
+
+        vector_t dir{len * dir_dist(gen), len * dir_dist(gen), len * dir_dist(gen)};
+        if (i % 10 == 0) dir = vector_t{0, 0, (i % 20 == 0) ? len : -len};
+
+        /* a third of the rays is aimed at the center of the scene so that most of them hit something */
+        if (i % 3 == 0)
+            dir = vector_t{-origin.get_x() / len, -origin.get_y() / len, -origin.get_z() / len};
+
+        rays.emplace_back(origin, dir);
+    }
+
+    return rays;
+}
+
+bool same_hit(const ray_hit_t &a, const ray_hit_t &b) { return a.id == b.id && a.dist == b.dist; }
+
+/**
+ * \brief cast_ray() in every mode and cast_rays() against brute_force_hits()
+*/
+void check_rays(const octrees::octree_t &tree, const triag_vector &triags, const std::vector<ray_t> &rays, double max_dist)
+{
+    size_t hit_num = 0;
+
+    std::vector<std::vector<ray_hit_t>> all_hits;
+
+    for (size_t r = 0; r < rays.size(); ++r)
+    {
+        SCOPED_TRACE("ray " + std::to_string(r));
+
+        std::vector<ray_hit_t> expected = brute_force_hits(triags, rays[r], max_dist);
+        hit_num += !expected.empty();
+
+        std::vector<ray_hit_t> all = tree.cast_ray(rays[r], octrees::ALL_HITS, max_dist);
+
+        ASSERT_EQ(all.size(), expected.size());
+        for (size_t i = 0; i < all.size(); ++i) ASSERT_TRUE(same_hit(all[i], expected[i]));
+
+        all_hits.push_back(all);
+
+        std::vector<ray_hit_t> closest = tree.cast_ray(rays[r], octrees::CLOSEST_HIT, max_dist);
+        std::vector<ray_hit_t> any     = tree.cast_ray(rays[r], octrees::ANY_HIT, max_dist);
+
+        if (expected.empty())
+        {
+            EXPECT_TRUE(closest.empty());
+            EXPECT_TRUE(any.empty());
+            continue;
+        }
+
+        /* several triags may be hit at the same distance, any of them is the closest */
+        ASSERT_EQ(closest.size(), 1u);
+        EXPECT_EQ(closest[0].dist, expected[0].dist);
+
+        auto is_expected = [&expected] (const ray_hit_t &hit) {
+            return std::any_of(expected.begin(), expected.end(), [&hit] (const ray_hit_t &it) { return same_hit(it, hit); });
+        };
+
+        EXPECT_TRUE(is_expected(closest[0]));
+
+        ASSERT_EQ(any.size(), 1u);
+        EXPECT_TRUE(is_expected(any[0]));
+    }
+
+    /* most rays have to hit something or the comparison says little */
+    ASSERT_GT(hit_num, rays.size() / 3);
+
+    for (size_t thread_num : {1, 4})
+    {
+        std::vector<std::vector<ray_hit_t>> batch = tree.cast_rays(rays, octrees::ALL_HITS, thread_num, max_dist);
+        ASSERT_EQ(batch.size(), rays.size());
+
+        for (size_t r = 0; r < rays.size(); ++r)
+        {
+            ASSERT_EQ(batch[r].size(), all_hits[r].size());
+            for (size_t i = 0; i < batch[r].size(); ++i) ASSERT_TRUE(same_hit(batch[r][i], all_hits[r][i]));
+        }
+    }
+}
+
+}
+
+//-------------------------------------------------------------------------------//
+
+TEST(octree_rays, triag_hit_distance)
+{
+    triangle_t triag{point_t{0, 0, 0}, point_t{4, 0, 0}, point_t{0, 4, 0}};
+
+    EXPECT_DOUBLE_EQ(triag.intersect_ray(ray_t{point_t{1, 1, 3}, vector_t{0, 0, -1}}), 3);
+    EXPECT_DOUBLE_EQ(triag.intersect_ray(ray_t{point_t{1, 1, 3}, vector_t{0, 0, -2}}), 1.5); // t is in lengths of dir
+    EXPECT_DOUBLE_EQ(triag.intersect_ray(ray_t{point_t{1, 1, -3}, vector_t{1, 1, 3}}), 1);
+    EXPECT_DOUBLE_EQ(triag.intersect_ray(ray_t{point_t{1, 1, 0}, vector_t{0, 0, 1}}), 0);    // origin on the triag
+
+    EXPECT_TRUE(std::isnan(triag.intersect_ray(ray_t{point_t{1, 1, 3}, vector_t{0, 0, 1}})));  // the triag is behind
+    EXPECT_TRUE(std::isnan(triag.intersect_ray(ray_t{point_t{3, 3, 3}, vector_t{0, 0, -1}}))); // past the hypotenuse
+    EXPECT_TRUE(std::isnan(triag.intersect_ray(ray_t{point_t{-1, 1, 0}, vector_t{1, 0, 0}}))); // in the plane
+
+    triangle_t segment{point_t{0, 0, 0}, point_t{4, 0, 0}, point_t{4, 0, 0}};
+    EXPECT_TRUE(std::isnan(segment.intersect_ray(ray_t{point_t{1, 0, 3}, vector_t{0, 0, -1}})));
+}
+
+TEST(octree_rays, casts_match_brute_force)
+{
+    triag_vector triags = random_scene(test_scenes()[1], 91);
+    std::vector<ray_t> rays = random_rays(92);
+
+    for (double loose_factor : {1.0, 2.0})
+        for (bool float_filter : {false, true})
+        {
+            SCOPED_TRACE("loose factor " + std::to_string(loose_factor) + (float_filter ? ", float" : ""));
+
+            octrees::octree_params_t params;
+            params.loose_factor = loose_factor;
+            params.leaf_size    = 16;
+            params.float_filter = float_filter;
+
+            octrees::octree_t tree{triags, params};
+            ASSERT_GT(tree.node_num(), 1u);
+
+            check_rays(tree, triags, rays, std::numeric_limits<double>::infinity());
+
+            /* the directions are up to 10 long, so this cuts the rays at a few dozen units */
+            SCOPED_TRACE("max dist");
+            check_rays(tree, triags, rays, 8);
+        }
+}
+
+TEST(octree_rays, empty_tree_is_never_hit)
+{
+    octrees::octree_t tree{triag_vector{}};
+    std::vector<ray_t> rays = random_rays(93);
+
+    EXPECT_TRUE(tree.cast_ray(rays[0]).empty());
+    EXPECT_EQ(tree.cast_rays(rays, octrees::ALL_HITS, 4).size(), rays.size());
+}
+
+//-------------------------------------------------------------------------------//
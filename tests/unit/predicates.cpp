@@ -0,0 +1,137 @@
+#include <gtest/gtest.h>
+
+#include "predicates.hpp"
+#include "exact_intersection.hpp"
+#include "scenes.hpp"
+#include <random>
+
+using namespace scenes;
+
+//-------------------------------------------------------------------------------//
+
+namespace {
+
+/* integers below 2^30 are exact doubles, so the filtered double predicates must agree with the int128 ones */
+const int64_t CRD_LIMIT = (int64_t{1} << 30);
+
+point_t to_point(const int_point_t &pnt)
+{
+    return {static_cast<double>(pnt.get_x()), static_cast<double>(pnt.get_y()), static_cast<double>(pnt.get_z())};
+}
+
+int_point_t to_int_point(const point_t &pnt)
+{
+    return {static_cast<int64_t>(pnt.get_x()), static_cast<int64_t>(pnt.get_y()), static_cast<int64_t>(pnt.get_z())};
+}
+
+/**
+ * \brief d is on the plane of a, b, c or one unit off it: a, b, c are random and d = a + s (b - a) + t (c - a) + jitter
+*/
+void near_plane_points(std::mt19937_64 &gen, int_point_t (&pnts)[4])
+{
+    std::uniform_int_distribution<int64_t> crd_dist{-CRD_LIMIT / 8, CRD_LIMIT / 8};
+    std::uniform_int_distribution<int64_t> coeff_dist{-3, 3};
+    std::uniform_int_distribution<int64_t> jitter_dist{-1, 1};
+
+    for (int i = 0; i < 3; ++i) pnts[i] = {crd_dist(gen), crd_dist(gen), crd_dist(gen)};
+
+    int64_t s = coeff_dist(gen), t = coeff_dist(gen);
+    auto along = [&] (int64_t a, int64_t b, int64_t c) { return a + s * (b - a) + t * (c - a) + jitter_dist(gen); };
+
+    pnts[3] = {along(pnts[0].get_x(), pnts[1].get_x(), pnts[2].get_x()),
+               along(pnts[0].get_y(), pnts[1].get_y(), pnts[2].get_y()),
+               along(pnts[0].get_z(), pnts[1].get_z(), pnts[2].get_z())};
+}
+
+}
+
+//-------------------------------------------------------------------------------//
+
+TEST(predicates, orient3d_matches_integers_near_the_plane)
+{
+    std::mt19937_64 gen{21};
+    size_t zero_num = 0;
+
+    for (int i = 0; i < 20000; ++i)
+    {
+        int_point_t pnts[4];
+        near_plane_points(gen, pnts);
+
+        int expected = predicates::orient3d(pnts[0], pnts[1], pnts[2], pnts[3]);
+        zero_num += (expected == 0);
+
+        ASSERT_EQ(predicates::orient3d(to_point(pnts[0]), to_point(pnts[1]), to_point(pnts[2]), to_point(pnts[3])), expected);
+
+        /* swapping two rows changes the sign */
+        ASSERT_EQ(predicates::orient3d(to_point(pnts[1]), to_point(pnts[0]), to_point(pnts[2]), to_point(pnts[3])), -expected);
+    }
+
+    EXPECT_GT(zero_num, 0u);
+}
+
+TEST(predicates, orient2d_matches_integers_near_the_line)
+{
+    std::mt19937_64 gen{22};
+    std::uniform_int_distribution<int64_t> crd_dist{-CRD_LIMIT, CRD_LIMIT};
+    std::uniform_int_distribution<int64_t> coeff_dist{-4, 4};
+    std::uniform_int_distribution<int64_t> jitter_dist{-1, 1};
+
+    size_t zero_num = 0;
+
+    for (int i = 0; i < 20000; ++i)
+    {
+        int64_t ax = crd_dist(gen) / 8, ay = crd_dist(gen) / 8, bx = crd_dist(gen) / 8, by = crd_dist(gen) / 8;
+        int64_t s  = coeff_dist(gen);
+        int64_t cx = ax + s * (bx - ax) + jitter_dist(gen), cy = ay + s * (by - ay) + jitter_dist(gen);
+
+        int expected = predicates::orient2d(ax, ay, bx, by, cx, cy);
+        zero_num += (expected == 0);
+
+        auto d = [] (int64_t crd) { return static_cast<double>(crd); };
+        ASSERT_EQ(predicates::orient2d(d(ax), d(ay), d(bx), d(by), d(cx), d(cy)), expected);
+    }
+
+    EXPECT_GT(zero_num, 0u);
+}
+
+TEST(predicates, orient3d_sees_one_ulp)
+{
+    point_t a{0.1, 0.2, 0.3}, b{1.7, 0.2, 0.3}, c{0.1, 2.9, 0.3};
+
+    EXPECT_EQ(predicates::orient3d(a, b, c, point_t{0.5, 0.5, 0.3}), 0);
+    EXPECT_NE(predicates::orient3d(a, b, c, point_t{0.5, 0.5, std::nextafter(0.3, 1.0)}), 0);
+    EXPECT_EQ(predicates::orient3d(a, b, c, point_t{0.5, 0.5, std::nextafter(0.3, 1.0)}),
+             -predicates::orient3d(a, b, c, point_t{0.5, 0.5, std::nextafter(0.3, 0.0)}));
+}
+
+TEST(predicates, exact_test_matches_integer_test)
+{
+    scene_params_t params;
+    params.triag_num  = 1500;
+    params.extent     = 60;
+    params.max_size   = 8;
+    params.degenerate = 0.1;
+    params.flat       = 0.3;
+    params.step       = 1;
+
+    triag_vector triags = random_scene(params, 23);
+
+    size_t hit_num = 0;
+
+    for (size_t i = 0, num = triags.size(); i < num; ++i)
+        for (size_t j = i + 1; j < num; ++j)
+        {
+            const triangle_t &t1 = triags[i].triag, &t2 = triags[j].triag;
+
+            bool expected = exact::triags_intersect(to_int_point(t1.getA()), to_int_point(t1.getB()), to_int_point(t1.getC()),
+                                                    to_int_point(t2.getA()), to_int_point(t2.getB()), to_int_point(t2.getC()));
+            hit_num += expected;
+
+            ASSERT_EQ(t1.intersects_exact(t2), expected) << "triags " << i << " and " << j;
+            ASSERT_EQ(t2.intersects_exact(t1), expected) << "triags " << j << " and " << i;
+        }
+
+    EXPECT_GT(hit_num, 0u);
+}
+
+//-------------------------------------------------------------------------------//
@@ -0,0 +1,140 @@
+#pragma once
+
+#include "octree.hpp"
+#include <cmath>
+#include <random>
+#include <vector>
+
+
+namespace scenes {
+
+using octrees::triag_vector;
+using octrees::pair_vector;
+
+struct scene_params_t
+{
+    size_t triag_num  = 1000;
+    double extent     = 100;  // centers of the triags lie in [-extent, extent]^3
+    double min_size   = 1;    // edges are up to size long, size is log-uniform in [min_size, max_size]
+    double max_size   = 10;
+    double degenerate = 0.05; // share of segments and points
+    double flat       = 0;    // share of triags put into the plane z = 0
+    double step       = 0;    // vertices are rounded to multiples of step if it is not zero
+};
+
+/**
+ * \brief random triags with ids 0..triag_num-1 in input order
+*/
+inline triag_vector random_scene(const scene_params_t &params, unsigned seed)
+{
+    std::mt19937_64 gen{seed};
+
+    std::uniform_real_distribution<double> center_dist{-params.extent, params.extent};
+    std::uniform_real_distribution<double> unit_dist{-1, 1};
+    std::uniform_real_distribution<double> share_dist{0, 1};
+    std::uniform_real_distribution<double> log_size_dist{std::log(params.min_size), std::log(params.max_size)};
+
+    auto round = [&params] (double crd) { return params.step > 0 ? std::round(crd / params.step) * params.step : crd; };
+
+    triag_vector triags;
+    triags.reserve(params.triag_num);
+
+    for (size_t i = 0; i < params.triag_num; ++i)
+    {
+        bool flat = share_dist(gen) < params.flat;
+
+        double center[3] = {center_dist(gen), center_dist(gen), flat ? 0 : center_dist(gen)};
+        double size      = std::exp(log_size_dist(gen));
+
+        point_t pnts[3];
+        for (point_t &pnt : pnts)
+            pnt = point_t{round(center[0] + size * unit_dist(gen)), round(center[1] + size * unit_dist(gen)),
+                          flat ? 0 : round(center[2] + size * unit_dist(gen))};
+
+        double kind = share_dist(gen);
+        if (kind < params.degenerate / 2)
+            pnts[1] = pnts[2] = pnts[0];
+        else if (kind < params.degenerate)
+            pnts[2] = pnts[1];
+
+        triags.push_back({triangle_t{pnts[0], pnts[1], pnts[2]}, i});
+    }
+
+    return triags;
+}
+
+/**
+ * \brief flags of the triags that intersect another one by test(triag1, triag2), every pair is tested
+*/
+template <typename F>
+std::vector<bool> brute_force(const triag_vector &triags, F test)
+{
+    std::vector<bool> answer(triags.size(), false);
+
+    for (size_t i = 0, num = triags.size(); i < num; ++i)
+        for (size_t j = i + 1; j < num; ++j)
+            if (test(triags[i].triag, triags[j].triag)) answer[triags[i].id] = answer[triags[j].id] = true;
+
+    return answer;
+}
+
+inline std::vector<bool> brute_force(const triag_vector &triags)
+{
+    return brute_force(triags, [] (const triangle_t &a, const triangle_t &b) { return a.intersects(b); });
+}
+
+/**
+ * \brief every intersecting pair (i, j), i < j, in sorted order
+*/
+inline pair_vector brute_force_pairs(const triag_vector &triags)
+{
+    pair_vector pairs;
+
+    for (size_t i = 0, num = triags.size(); i < num; ++i)
+        for (size_t j = i + 1; j < num; ++j)
+            if (triags[i].triag.intersects(triags[j].triag))
+                pairs.emplace_back(static_cast<octrees::index_t>(triags[i].id), static_cast<octrees::index_t>(triags[j].id));
+
+    octrees::sort_pairs(pairs);
+    return pairs;
+}
+
+inline std::vector<bool> flags_of(const pair_vector &pairs, size_t triag_num)
+{
+    std::vector<bool> answer(triag_num, false);
+    for (auto &pair : pairs) answer[pair.first] = answer[pair.second] = true;
+
+    return answer;
+}
+
+inline size_t count(const std::vector<bool> &answer)
+{
+    size_t num = 0;
+    for (bool flag : answer) num += flag;
+
+    return num;
+}
+
+/**
+ * \brief scenes the engines are compared on: small evenly sized triags, sizes spread over three orders
+ *        of magnitude, and half of the triags in one plane
+*/
+inline std::vector<scene_params_t> test_scenes()
+{
+    scene_params_t even;
+    even.triag_num = 2000;
+
+    scene_params_t mixed;
+    mixed.triag_num = 1500;
+    mixed.min_size  = 0.2;
+    mixed.max_size  = 150;
+
+    scene_params_t flat;
+    flat.triag_num = 1500;
+    flat.flat      = 0.5;
+    flat.max_size  = 15;
+
+    return {even, mixed, flat};
+}
+
+}
@@ -0,0 +1,55 @@
+#include <gtest/gtest.h>
+
+#include "engine_checks.hpp"
+
+using namespace scenes;
+
+//-------------------------------------------------------------------------------//
+
+TEST(spatial_hash, flags_match_brute_force)
+{
+    check_flags(collisions::GRID);
+}
+
+TEST(spatial_hash, pairs_match_brute_force)
+{
+    check_pairs(collisions::GRID);
+}
+
+TEST(spatial_hash, empty_and_single_scenes)
+{
+    check_empty_and_single(collisions::GRID);
+}
+
+TEST(spatial_hash, grid_levels_keep_the_answer)
+{
+    /* sizes over three orders of magnitude, the large triags go to several coarser levels */
+    scene_params_t params;
+    params.triag_num = 3000;
+    params.min_size  = 0.5;
+    params.max_size  = 400;
+
+    triag_vector triags = random_scene(params, 7);
+    pair_vector expected = brute_force_pairs(triags);
+
+    grids::spatial_hash_t grid{triags};
+    EXPECT_GT(grid.level_num(), 2u);
+
+    for (size_t thread_num : THREAD_NUMS)
+    {
+        SCOPED_TRACE(std::to_string(thread_num) + " threads");
+
+        pair_vector pairs;
+        grid.get_collisions(pairs, thread_num);
+        octrees::sort_pairs(pairs);
+
+        EXPECT_EQ(pairs, expected);
+
+        std::vector<bool> answer(triags.size(), false);
+        grid.get_collisions(answer, thread_num);
+
+        EXPECT_EQ(answer, flags_of(expected, triags.size()));
+    }
+}
+
+//-------------------------------------------------------------------------------//
@@ -0,0 +1,184 @@
+#include <gtest/gtest.h>
+
+#include "streaming.hpp"
+#include "scenes.hpp"
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+using namespace scenes;
+
+//-------------------------------------------------------------------------------//
+
+namespace {
+
+std::string to_text(const triag_vector &triags)
+{
+    std::ostringstream out;
+    out.precision(17);
+
+    out << triags.size() << "\n";
+    for (auto &it : triags)
+        for (const point_t &pnt : {it.triag.getA(), it.triag.getB(), it.triag.getC()})
+            out << pnt.get_x() << " " << pnt.get_y() << " " << pnt.get_z() << "\n";
+
+    return out.str();
+}
+
+std::filesystem::path make_tmp_dir(const std::string &name)
+{
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / name;
+
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+
+    return dir;
+}
+
+}
+
+//-------------------------------------------------------------------------------//
+
+TEST(streaming, tiles_match_brute_force)
+{
+    std::filesystem::path dir = make_tmp_dir("triag_streaming_test");
+
+    for (const scene_params_t &params : test_scenes())
+    {
+        triag_vector triags = random_scene(params, 41);
+        std::vector<bool> expected = brute_force(triags);
+
+        /* budgets of the whole scene, of 200 and of 5 triags per tile: no split, one level of splits and nested ones */
+        for (size_t budget : {triags.size(), size_t{200}, size_t{5}})
+        {
+            SCOPED_TRACE(std::to_string(triags.size()) + " triags, budget " + std::to_string(budget));
+
+            streaming::stream_params_t stream_params;
+            stream_params.memory_budget = budget * streaming::TILE_BYTES_PER_TRIAG;
+            stream_params.tmp_dir       = dir.string();
+
+            streaming::tile_processor_t processor{collisions::OCTREE, collisions::engine_params_t{2}, stream_params};
+
+            std::istringstream in{to_text(triags)};
+            std::vector<bool> answer;
+
+            streaming::stream_stats_t stats = processor.find_collisions(in, answer);
+
+            EXPECT_EQ(answer, expected);
+            EXPECT_EQ(stats.triag_num, triags.size());
+            EXPECT_GE(stats.tile_num, 1u);
+        }
+    }
+
+    /* tile files and their directory are removed */
+    EXPECT_TRUE(std::filesystem::is_empty(dir));
+    std::filesystem::remove_all(dir);
+}
+
+TEST(streaming, every_engine_runs_on_tiles)
+{
+    std::filesystem::path dir = make_tmp_dir("triag_streaming_engines_test");
+
+    triag_vector triags = random_scene(test_scenes()[0], 42);
+    std::vector<bool> expected = brute_force(triags);
+
+    for (int engine = 0; engine < collisions::ENGINE_NUM; ++engine)
+    {
+        SCOPED_TRACE(collisions::engine_names[engine]);
+
+        streaming::stream_params_t stream_params;
+        stream_params.memory_budget = 100 * streaming::TILE_BYTES_PER_TRIAG;
+        stream_params.tmp_dir       = dir.string();
+
+        streaming::tile_processor_t processor{static_cast<collisions::engine_type>(engine), collisions::engine_params_t{1}, stream_params};
+
+        std::istringstream in{to_text(triags)};
+        std::vector<bool> answer;
+        processor.find_collisions(in, answer);
+
+        EXPECT_EQ(answer, expected);
+    }
+
+    std::filesystem::remove_all(dir);
+}
+
+TEST(streaming, thin_scene_is_split)
+{
+    std::filesystem::path dir = make_tmp_dir("triag_streaming_thin_test");
+
+    /* the scene is 1e-15 thick, the ACCURACY margin of a box is 10^10 tiles of that axis away */
+    scene_params_t params = test_scenes()[0];
+    params.flat = 1;
+
+    triag_vector triags = random_scene(params, 43);
+    for (size_t i = 0; i < triags.size(); i += 2)
+    {
+        const triangle_t &t = triags[i].triag;
+        triags[i].triag = triangle_t{t.getA(), t.getB(), point_t{t.getC().get_x(), t.getC().get_y(), 1e-15}};
+    }
+
+    streaming::stream_params_t stream_params;
+    stream_params.memory_budget = 50 * streaming::TILE_BYTES_PER_TRIAG;
+    stream_params.tmp_dir       = dir.string();
+
+    streaming::tile_processor_t processor{collisions::OCTREE, collisions::engine_params_t{1}, stream_params};
+
+    std::istringstream in{to_text(triags)};
+    std::vector<bool> answer;
+    processor.find_collisions(in, answer);
+
+    EXPECT_EQ(answer, brute_force(triags));
+
+    std::filesystem::remove_all(dir);
+}
+
+TEST(streaming, bad_tmp_dir_throws)
+{
+    std::filesystem::path dir  = make_tmp_dir("triag_streaming_bad_dir_test");
+    std::filesystem::path file = dir / "file";
+
+    std::ofstream{file} << "not a directory";
+
+    for (const std::filesystem::path &tmp_dir : {dir / "missing", file})
+    {
+        streaming::stream_params_t stream_params;
+        stream_params.tmp_dir = tmp_dir.string();
+
+        streaming::tile_processor_t processor{collisions::OCTREE, collisions::engine_params_t{1}, stream_params};
+
+        std::istringstream in{to_text(random_scene(scene_params_t{10}, 44))};
+        std::vector<bool> answer;
+
+        EXPECT_THROW(processor.find_collisions(in, answer), std::runtime_error);
+    }
+
+    std::filesystem::remove_all(dir);
+}
+
+TEST(streaming, short_input_throws)
+{
+    std::filesystem::path dir = make_tmp_dir("triag_streaming_short_input_test");
+
+    std::string text = to_text(random_scene(scene_params_t{10}, 45));
+
+    /* the last triag is cut in the middle, and a triag has a word instead of a coordinate */
+    for (const std::string &bad_text : {text.substr(0, text.size() - 20), std::string{"2\n0 0 0 1 0 0 0 1 0\n0 0 x 1 0 0 0 1 0\n"}})
+    {
+        streaming::stream_params_t stream_params;
+        stream_params.tmp_dir = dir.string();
+
+        streaming::tile_processor_t processor{collisions::OCTREE, collisions::engine_params_t{1}, stream_params};
+
+        std::istringstream in{bad_text};
+        std::vector<bool> answer;
+
+        EXPECT_THROW(processor.find_collisions(in, answer), std::runtime_error);
+
+        /* the tiles written before the error are removed */
+        EXPECT_TRUE(std::filesystem::is_empty(dir));
+    }
+
+    std::filesystem::remove_all(dir);
+}
+
+//-------------------------------------------------------------------------------//
@@ -0,0 +1,24 @@
+#include <gtest/gtest.h>
+
+#include "engine_checks.hpp"
+
+using namespace scenes;
+
+//-------------------------------------------------------------------------------//
+
+TEST(sweep_prune, flags_match_brute_force)
+{
+    check_flags(collisions::SAP);
+}
+
+TEST(sweep_prune, pairs_match_brute_force)
+{
+    check_pairs(collisions::SAP);
+}
+
+TEST(sweep_prune, empty_and_single_scenes)
+{
+    check_empty_and_single(collisions::SAP);
+}
+
+//-------------------------------------------------------------------------------//